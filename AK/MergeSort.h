@@ -0,0 +1,61 @@
+#pragma once
+
+#include "StdLibExtras.h"
+#include "Vector.h"
+
+namespace AK {
+
+// A stable merge sort. Halves that are already in order relative to each other are not merged,
+// so input that is sorted (or nearly so) costs little more than one pass of comparisons.
+
+template<typename T, typename LessThan>
+void merge_sort_impl(T* data, T* buffer, int count, LessThan less_than)
+{
+    if (count <= 16) {
+        for (int i = 1; i < count; ++i) {
+            if (!less_than(data[i], data[i - 1]))
+                continue;
+            T value = move(data[i]);
+            int j = i;
+            for (; j > 0 && less_than(value, data[j - 1]); --j)
+                data[j] = move(data[j - 1]);
+            data[j] = move(value);
+        }
+        return;
+    }
+
+    int middle = count / 2;
+    merge_sort_impl(data, buffer, middle, less_than);
+    merge_sort_impl(data + middle, buffer, count - middle, less_than);
+    if (!less_than(data[middle], data[middle - 1]))
+        return;
+
+    for (int i = 0; i < middle; ++i)
+        buffer[i] = move(data[i]);
+    int left = 0;
+    int right = middle;
+    int out = 0;
+    while (left < middle && right < count) {
+        // Take from the right half only if strictly less, so equal elements keep their order.
+        if (less_than(data[right], buffer[left]))
+            data[out++] = move(data[right++]);
+        else
+            data[out++] = move(buffer[left++]);
+    }
+    while (left < middle)
+        data[out++] = move(buffer[left++]);
+}
+
+template<typename T, typename LessThan>
+void merge_sort(Vector<T>& vector, LessThan less_than)
+{
+    if (vector.size() < 2)
+        return;
+    Vector<T> buffer;
+    buffer.resize(vector.size() / 2);
+    merge_sort_impl(vector.data(), buffer.data(), vector.size(), less_than);
+}
+
+}
+
+using AK::merge_sort;
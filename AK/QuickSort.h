@@ -1,45 +1,121 @@
 #pragma once
 
+#include "StdLibExtras.h"
+
 namespace AK {
 
+// An introsort: quicksort with a median-of-three pivot, insertion sort for short ranges,
+// and a heapsort fallback if the recursion gets too deep. Not stable; see MergeSort.h for that.
+
+template<typename T>
+bool is_less_than(const T& a, const T& b)
+{
+    return a < b;
+}
+
 template<typename IteratorType, typename LessThan>
-IteratorType partition(IteratorType first, IteratorType last, LessThan less_than)
+void insertion_sort_impl(IteratorType begin, int first, int last, LessThan less_than)
 {
-    auto pivot = last;
-    auto smallest = first - 1;
-    auto it = first;
-    for (; it < last; ++it) {
-        if (less_than(*it, *pivot)) {
-            ++smallest;
-            swap(*it, *smallest);
-        }
+    for (int i = first + 1; i <= last; ++i) {
+        for (int j = i; j > first && less_than(*(begin + j), *(begin + (j - 1))); --j)
+            swap(*(begin + j), *(begin + (j - 1)));
     }
-    swap(*(smallest + 1), *last);
-    return smallest + 1;
 }
 
 template<typename IteratorType, typename LessThan>
-void quick_sort_impl(IteratorType begin, IteratorType first, IteratorType last, LessThan less_than)
+void sift_down(IteratorType begin, int first, int root, int count, LessThan less_than)
 {
-    if (first < last) {
-        auto pivot = partition(first, last, less_than);
-        quick_sort_impl(begin, first, pivot - 1, less_than);
-        quick_sort_impl(begin, pivot + 1, last, less_than);
+    for (;;) {
+        int child = root * 2 + 1;
+        if (child >= count)
+            return;
+        if (child + 1 < count && less_than(*(begin + (first + child)), *(begin + (first + child + 1))))
+            ++child;
+        if (!less_than(*(begin + (first + root)), *(begin + (first + child))))
+            return;
+        swap(*(begin + (first + root)), *(begin + (first + child)));
+        root = child;
     }
 }
 
-template<typename T>
-bool is_less_than(const T& a, const T& b)
+template<typename IteratorType, typename LessThan>
+void heap_sort_impl(IteratorType begin, int first, int last, LessThan less_than)
 {
-    return a < b;
+    int count = last - first + 1;
+    for (int i = count / 2 - 1; i >= 0; --i)
+        sift_down(begin, first, i, count, less_than);
+    for (int i = count - 1; i > 0; --i) {
+        swap(*(begin + first), *(begin + (first + i)));
+        sift_down(begin, first, 0, i, less_than);
+    }
+}
+
+// Leaves the median of the first, middle and last elements at 'first' and returns its final position.
+// Stopping on elements equal to the pivot keeps ranges full of duplicates balanced.
+template<typename IteratorType, typename LessThan>
+int partition(IteratorType begin, int first, int last, LessThan less_than)
+{
+    int middle = first + (last - first) / 2;
+    if (less_than(*(begin + middle), *(begin + first)))
+        swap(*(begin + middle), *(begin + first));
+    if (less_than(*(begin + last), *(begin + middle))) {
+        swap(*(begin + last), *(begin + middle));
+        if (less_than(*(begin + middle), *(begin + first)))
+            swap(*(begin + middle), *(begin + first));
+    }
+    swap(*(begin + first), *(begin + middle));
+
+    auto& pivot = *(begin + first);
+    int i = first;
+    int j = last + 1;
+    for (;;) {
+        while (less_than(*(begin + ++i), pivot)) {
+            if (i == last)
+                break;
+        }
+        while (less_than(pivot, *(begin + --j))) {
+            if (j == first)
+                break;
+        }
+        if (i >= j)
+            break;
+        swap(*(begin + i), *(begin + j));
+    }
+    swap(*(begin + first), *(begin + j));
+    return j;
+}
+
+template<typename IteratorType, typename LessThan>
+void quick_sort_impl(IteratorType begin, int first, int last, int depth_limit, LessThan less_than)
+{
+    while (last - first > 16) {
+        if (!depth_limit--) {
+            heap_sort_impl(begin, first, last, less_than);
+            return;
+        }
+        int pivot = partition(begin, first, last, less_than);
+        // Recurse into the smaller half and loop on the larger one to bound the stack depth.
+        if (pivot - first < last - pivot) {
+            quick_sort_impl(begin, first, pivot - 1, depth_limit, less_than);
+            first = pivot + 1;
+        } else {
+            quick_sort_impl(begin, pivot + 1, last, depth_limit, less_than);
+            last = pivot - 1;
+        }
+    }
+    insertion_sort_impl(begin, first, last, less_than);
 }
 
 template<typename IteratorType, typename LessThan>
 void quick_sort(IteratorType begin, IteratorType end, LessThan less_than = is_less_than)
 {
-    if (begin == end)
+    int count = end - begin;
+    if (count < 2)
         return;
-    quick_sort_impl(begin, begin, end - 1, less_than);
+    int depth_limit = 0;
+    for (int n = count; n > 1; n >>= 1)
+        depth_limit += 2;
+    quick_sort_impl(begin, 0, count - 1, depth_limit, less_than);
 }
 
 }
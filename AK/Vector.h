@@ -277,6 +277,7 @@ public:
         Iterator& operator++() { ++m_index; return *this; }
         Iterator operator-(int value) { return { m_vector, m_index - value }; }
         Iterator operator+(int value) { return { m_vector, m_index + value }; }
+        int operator-(const Iterator& other) { return m_index - other.m_index; }
         T& operator*() { return m_vector[m_index]; }
     private:
         friend class Vector;
@@ -296,6 +297,7 @@ public:
         ConstIterator& operator++() { ++m_index; return *this; }
         ConstIterator operator-(int value) { return { m_vector, m_index - value }; }
         ConstIterator operator+(int value) { return { m_vector, m_index + value }; }
+        int operator-(const ConstIterator& other) { return m_index - other.m_index; }
         const T& operator*() const { return m_vector[m_index]; }
     private:
         friend class Vector;
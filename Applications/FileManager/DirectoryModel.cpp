@@ -1,61 +1,165 @@
 #include "DirectoryModel.h"
+#include "ThumbnailStore.h"
 #include <dirent.h>
 #include <stdio.h>
 #include <unistd.h>
 #include <grp.h>
 #include <pwd.h>
 #include <AK/FileSystemPath.h>
-#include <AK/StringBuilder.h>
 #include <SharedGraphics/GraphicsBitmap.h>
-#include <LibGUI/GPainter.h>
-#include <LibGUI/GLock.h>
+#include <SharedGraphics/PNGLoader.h>
+#include <LibGUI/GTimer.h>
 
-static GLockable<HashMap<String, RetainPtr<GraphicsBitmap>>>& thumbnail_cache()
+struct ThumbnailCache {
+    HashMap<String, RetainPtr<GraphicsBitmap>> thumbnails;
+    // Paths waiting for a worker, oldest first.
+    Vector<String> queue;
+    // Progress through the current batch, i.e. everything queued since the queue last ran dry.
+    int batch_total { 0 };
+    int batch_done { 0 };
+};
+
+static GLockable<ThumbnailCache>& thumbnail_cache()
+{
+    static GLockable<ThumbnailCache>* s_cache;
+    if (!s_cache)
+        s_cache = new GLockable<ThumbnailCache>();
+    return *s_cache;
+}
+
+static RetainPtr<GraphicsBitmap> load_or_generate_thumbnail(const String& path)
 {
-    static GLockable<HashMap<String, RetainPtr<GraphicsBitmap>>>* s_map;
-    if (!s_map)
-        s_map = new GLockable<HashMap<String, RetainPtr<GraphicsBitmap>>>();
-    return *s_map;
+    struct stat st;
+    if (stat(path.characters(), &st) < 0)
+        return nullptr;
+    if (auto thumbnail = load_stored_thumbnail(path, st))
+        return thumbnail;
+    // Decode directly rather than through GraphicsBitmap::load_from_file(): the full-size image is
+    // only needed until it's scaled down, and the shared image cache belongs to the main thread.
+    auto png_bitmap = load_png(path);
+    if (!png_bitmap || png_bitmap->size().is_empty())
+        return nullptr;
+    auto thumbnail = generate_thumbnail(*png_bitmap);
+    store_thumbnail(path, st, *thumbnail);
+    return move(thumbnail);
 }
 
 int thumbnail_thread(void* model_ptr)
 {
     auto& model = *(DirectoryModel*)model_ptr;
     for (;;) {
-        sleep(1);
-        Vector<String> to_generate;
+        String path;
         {
             LOCKER(thumbnail_cache().lock());
-            for (auto& it : thumbnail_cache().resource()) {
-                if (it.value)
-                    continue;
-                to_generate.append(it.key);
-            }
+            auto& queue = thumbnail_cache().resource().queue;
+            if (!queue.is_empty())
+                path = queue.take_first();
         }
-        if (to_generate.is_empty())
+        if (path.is_null()) {
+            sleep(1);
             continue;
-        for (int i = 0; i < to_generate.size(); ++i) {
-            auto& path = to_generate[i];
-            auto png_bitmap = GraphicsBitmap::load_from_file(path);
-            if (!png_bitmap)
-                continue;
-            auto thumbnail = GraphicsBitmap::create(png_bitmap->format(), { 32, 32 });
-            Painter painter(*thumbnail);
-            painter.draw_scaled_bitmap(thumbnail->rect(), *png_bitmap, png_bitmap->rect());
-            {
-                LOCKER(thumbnail_cache().lock());
-                thumbnail_cache().resource().set(path, move(thumbnail));
+        }
+        auto thumbnail = load_or_generate_thumbnail(path);
+        int done;
+        int total;
+        {
+            LOCKER(thumbnail_cache().lock());
+            auto& cache = thumbnail_cache().resource();
+            // A thumbnail that couldn't be made stays null, and is never queued again.
+            cache.thumbnails.set(path, move(thumbnail));
+            done = ++cache.batch_done;
+            total = cache.batch_total;
+            if (done == total) {
+                cache.batch_done = 0;
+                cache.batch_total = 0;
             }
-            if (model.on_thumbnail_progress)
-                model.on_thumbnail_progress(i + 1, to_generate.size());
-            model.did_update();
         }
+        if (model.on_thumbnail_progress)
+            model.on_thumbnail_progress(done, total);
+        model.did_update();
+    }
+}
+
+int directory_scan_thread(void* model_ptr)
+{
+    auto& model = *(DirectoryModel*)model_ptr;
+    for (;;) {
+        int generation;
+        // Sleep until update() asks for a scan.
+        if (read(model.m_scan_request_fds[0], &generation, sizeof(generation)) != sizeof(generation)) {
+            perror("read");
+            ASSERT_NOT_REACHED();
+        }
+        String path;
+        {
+            LOCKER(model.m_scan.lock());
+            auto& scan = model.m_scan.resource();
+            // A newer request is already queued behind this one.
+            if (scan.generation != generation)
+                continue;
+            // Copied rather than shared, since String's retain count isn't safe to touch from two threads.
+            path = String(scan.path.characters(), scan.path.length());
+        }
+
+        Vector<DirectoryModel::Entry> batch;
+        auto hand_over = [&](bool is_finished) {
+            LOCKER(model.m_scan.lock());
+            auto& scan = model.m_scan.resource();
+            if (scan.generation != generation)
+                return false;
+            for (auto& entry : batch)
+                scan.entries.append(move(entry));
+            batch.clear();
+            scan.is_finished = is_finished;
+            return true;
+        };
+
+        DIR* dirp = opendir(path.characters());
+        if (!dirp)
+            perror("opendir");
+        bool is_current = true;
+        struct stat st;
+        while (dirp && is_current) {
+            auto* de = readdir_with_stat(dirp, &st);
+            if (!de)
+                break;
+            if (!strcmp(de->d_name, ".") || !strcmp(de->d_name, ".."))
+                continue;
+            DirectoryModel::Entry entry;
+            entry.name = de->d_name;
+            entry.size = st.st_size;
+            entry.mode = st.st_mode;
+            entry.uid = st.st_uid;
+            entry.gid = st.st_gid;
+            entry.inode = st.st_ino;
+            batch.append(move(entry));
+            // Hand entries over in batches, so the first rows show up before a big directory is done.
+            if (batch.size() >= 64)
+                is_current = hand_over(false);
+        }
+        if (dirp)
+            closedir(dirp);
+        if (is_current)
+            hand_over(true);
     }
 }
 
 DirectoryModel::DirectoryModel()
 {
-    create_thread(thumbnail_thread, this);
+    // Thumbnails are mostly decode-bound, so a couple of workers keep a big directory moving
+    // without starving the UI thread.
+    for (int i = 0; i < 2; ++i)
+        create_thread(thumbnail_thread, this);
+
+    // Directories are read on their own thread too, and the rows are taken in from the event loop as they arrive.
+    if (pipe(m_scan_request_fds) < 0) {
+        perror("pipe");
+        ASSERT_NOT_REACHED();
+    }
+    create_thread(directory_scan_thread, this);
+    m_scan_timer = make<GTimer>();
+    m_scan_timer->set_interval(50);
+    m_scan_timer->on_timeout = [this] { take_scanned_entries(); };
 
     m_directory_icon = GIcon::default_icon("filetype-folder");
     m_file_icon = GIcon::default_icon("filetype-unknown");
@@ -131,11 +235,14 @@ GIcon DirectoryModel::icon_for(const Entry& entry) const
         if (!entry.thumbnail) {
             auto path = entry.full_path(*this);
             LOCKER(thumbnail_cache().lock());
-            auto it = thumbnail_cache().resource().find(path);
-            if (it != thumbnail_cache().resource().end()) {
+            auto& cache = thumbnail_cache().resource();
+            auto it = cache.thumbnails.find(path);
+            if (it != cache.thumbnails.end()) {
                 entry.thumbnail = (*it).value.copy_ref();
             } else {
-                thumbnail_cache().resource().set(path, nullptr);
+                cache.thumbnails.set(path, nullptr);
+                cache.queue.append(path);
+                ++cache.batch_total;
             }
         }
         if (!entry.thumbnail)
@@ -145,42 +252,41 @@ GIcon DirectoryModel::icon_for(const Entry& entry) const
     return m_file_icon;
 }
 
-static String permission_string(mode_t mode)
+static GVariant permission_string(mode_t mode)
 {
-    StringBuilder builder;
+    // Built on the stack and kept inside the GVariant, since this runs for every row on every paint.
+    char buffer[10];
     if (S_ISDIR(mode))
-        builder.append("d");
+        buffer[0] = 'd';
     else if (S_ISLNK(mode))
-        builder.append("l");
+        buffer[0] = 'l';
     else if (S_ISBLK(mode))
-        builder.append("b");
+        buffer[0] = 'b';
     else if (S_ISCHR(mode))
-        builder.append("c");
+        buffer[0] = 'c';
     else if (S_ISFIFO(mode))
-        builder.append("f");
+        buffer[0] = 'f';
     else if (S_ISSOCK(mode))
-        builder.append("s");
+        buffer[0] = 's';
     else if (S_ISREG(mode))
-        builder.append("-");
+        buffer[0] = '-';
     else
-        builder.append("?");
-
-    builder.appendf("%c%c%c%c%c%c%c%c",
-        mode & S_IRUSR ? 'r' : '-',
-        mode & S_IWUSR ? 'w' : '-',
-        mode & S_ISUID ? 's' : (mode & S_IXUSR ? 'x' : '-'),
-        mode & S_IRGRP ? 'r' : '-',
-        mode & S_IWGRP ? 'w' : '-',
-        mode & S_ISGID ? 's' : (mode & S_IXGRP ? 'x' : '-'),
-        mode & S_IROTH ? 'r' : '-',
-        mode & S_IWOTH ? 'w' : '-'
-    );
+        buffer[0] = '?';
+
+    buffer[1] = mode & S_IRUSR ? 'r' : '-';
+    buffer[2] = mode & S_IWUSR ? 'w' : '-';
+    buffer[3] = mode & S_ISUID ? 's' : (mode & S_IXUSR ? 'x' : '-');
+    buffer[4] = mode & S_IRGRP ? 'r' : '-';
+    buffer[5] = mode & S_IWGRP ? 'w' : '-';
+    buffer[6] = mode & S_ISGID ? 's' : (mode & S_IXGRP ? 'x' : '-');
+    buffer[7] = mode & S_IROTH ? 'r' : '-';
+    buffer[8] = mode & S_IWOTH ? 'w' : '-';
 
     if (mode & S_ISVTX)
-        builder.append("t");
+        buffer[9] = 't';
     else
-        builder.appendf("%c", mode & S_IXOTH ? 'x' : '-');
-    return builder.to_string();
+        buffer[9] = mode & S_IXOTH ? 'x' : '-';
+    return GVariant(buffer, 10);
 }
 
 String DirectoryModel::name_for_uid(uid_t uid) const
@@ -234,39 +340,48 @@ GVariant DirectoryModel::data(const GModelIndex& index, Role role) const
 
 void DirectoryModel::update()
 {
-    DIR* dirp = opendir(m_path.characters());
-    if (!dirp) {
-        perror("opendir");
-        exit(1);
-    }
     m_directories.clear();
     m_files.clear();
-
     m_bytes_in_files = 0;
-    while (auto* de = readdir(dirp)) {
-        Entry entry;
-        entry.name = de->d_name;
-        if (entry.name == "." || entry.name == "..")
-            continue;
-        struct stat st;
-        int rc = lstat(String::format("%s/%s", m_path.characters(), de->d_name).characters(), &st);
-        if (rc < 0) {
-            perror("lstat");
-            continue;
-        }
-        entry.size = st.st_size;
-        entry.mode = st.st_mode;
-        entry.uid = st.st_uid;
-        entry.gid = st.st_gid;
-        entry.inode = st.st_ino;
-        auto& entries = S_ISDIR(st.st_mode) ? m_directories : m_files;
-        entries.append(move(entry));
 
-        if (S_ISREG(entry.mode))
-            m_bytes_in_files += st.st_size;
+    int generation;
+    {
+        LOCKER(m_scan.lock());
+        auto& scan = m_scan.resource();
+        generation = ++scan.generation;
+        scan.path = String(m_path.characters(), m_path.length());
+        scan.entries.clear();
+        scan.is_finished = false;
     }
-    closedir(dirp);
+    if (write(m_scan_request_fds[1], &generation, sizeof(generation)) != sizeof(generation)) {
+        perror("write");
+        ASSERT_NOT_REACHED();
+    }
+    m_scan_timer->start();
+
+    did_update();
+}
 
+void DirectoryModel::take_scanned_entries()
+{
+    Vector<Entry> entries;
+    bool is_finished;
+    {
+        LOCKER(m_scan.lock());
+        auto& scan = m_scan.resource();
+        entries = move(scan.entries);
+        is_finished = scan.is_finished;
+    }
+    if (is_finished)
+        m_scan_timer->stop();
+    if (entries.is_empty() && !is_finished)
+        return;
+    for (auto& entry : entries) {
+        if (S_ISREG(entry.mode))
+            m_bytes_in_files += entry.size;
+        auto& target = entry.is_directory() ? m_directories : m_files;
+        target.append(move(entry));
+    }
     did_update();
 }
 
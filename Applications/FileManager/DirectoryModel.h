@@ -1,11 +1,16 @@
 #pragma once
 
 #include <LibGUI/GModel.h>
+#include <LibGUI/GLock.h>
 #include <AK/HashMap.h>
+#include <AK/OwnPtr.h>
 #include <sys/stat.h>
 
+class GTimer;
+
 class DirectoryModel final : public GModel {
     friend int thumbnail_thread(void*);
+    friend int directory_scan_thread(void*);
 public:
     static Retained<DirectoryModel> create() { return adopt(*new DirectoryModel); }
     virtual ~DirectoryModel() override;
@@ -61,12 +66,25 @@ private:
         return m_files[index - m_directories.size()];
     }
     GIcon icon_for(const Entry& entry) const;
+    void take_scanned_entries();
 
     String m_path;
     Vector<Entry> m_files;
     Vector<Entry> m_directories;
     size_t m_bytes_in_files;
 
+    // Shared with the scan thread, which streams entries in here as it reads them.
+    struct Scan {
+        // Bumped for every new scan, so a scan that was overtaken stops handing over entries.
+        int generation { 0 };
+        String path;
+        Vector<Entry> entries;
+        bool is_finished { true };
+    };
+    GLockable<Scan> m_scan;
+    int m_scan_request_fds[2];
+    OwnPtr<GTimer> m_scan_timer;
+
     GIcon m_directory_icon;
     GIcon m_file_icon;
     GIcon m_symlink_icon;
@@ -0,0 +1,291 @@
+#include "ThumbnailStore.h"
+#include <AK/MappedFile.h>
+#include <AK/QuickSort.h>
+#include <AK/Vector.h>
+#include <LibGUI/GLock.h>
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pwd.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <utime.h>
+
+// At about 4 KiB a thumbnail, this keeps the store around 4 MiB. Going over prunes it back down to three quarters.
+static const int max_stored_thumbnails = 1024;
+// How many thumbnails a FileManager stores between looks at how big the store has grown.
+static const int stores_between_prunes = 64;
+
+static GLock s_prune_lock;
+static int s_stores_until_prune;
+
+static GLock s_home_directory_lock;
+static char s_home_directory[256];
+static bool s_home_directory_resolved;
+
+// A thumbnail file is this header, followed by the image's path (to catch hash collisions),
+// followed by thumbnail_size * thumbnail_size RGBA32 pixels.
+struct [[gnu::packed]] ThumbnailFileHeader {
+    char magic[4];
+    byte version;
+    byte format;
+    word width;
+    word height;
+    word path_length;
+    dword inode;
+    dword size;
+    dword mtime;
+};
+
+static const byte thumbnail_file_version = 1;
+
+// The store lives in the user's home directory, and is only used if it's a directory that belongs to
+// the user and that nobody else can get into. Otherwise someone else could plant files (or symlinks) in it.
+// With 'create', the directory (and ~/.cache) is made if it doesn't exist yet. Returns null if there's no usable store.
+// $HOME if it's set, or else the home directory from /etc/passwd. Looked up once, since getpwuid() isn't
+// safe to call from more than one thread at a time. Null if there's no home directory.
+static const char* home_directory()
+{
+    LOCKER(s_home_directory_lock);
+    if (!s_home_directory_resolved) {
+        s_home_directory_resolved = true;
+        const char* home = getenv("HOME");
+        if (!home || !*home) {
+            auto* passwd = getpwuid(getuid());
+            home = passwd ? passwd->pw_dir : nullptr;
+        }
+        if (home && strlen(home) < sizeof(s_home_directory))
+            strcpy(s_home_directory, home);
+    }
+    return *s_home_directory ? s_home_directory : nullptr;
+}
+
+static String thumbnail_directory(bool create)
+{
+    const char* home = home_directory();
+    if (!home)
+        return { };
+    auto cache_directory = String::format("%s/.cache", home);
+    auto directory = String::format("%s/thumbnails", cache_directory.characters());
+    if (create) {
+        mkdir(cache_directory.characters(), 0700);
+        mkdir(directory.characters(), 0700);
+    }
+    struct stat st;
+    if (lstat(directory.characters(), &st) < 0)
+        return { };
+    if (!S_ISDIR(st.st_mode) || st.st_uid != getuid() || (st.st_mode & 077)) {
+        if (create)
+            fprintf(stderr, "ThumbnailStore: Not using %s, it's not a private directory of ours\n", directory.characters());
+        return { };
+    }
+    return directory;
+}
+
+static String thumbnail_file_path(const String& directory, const String& path)
+{
+    return String::format("%s/%08x", directory.characters(), path.impl()->hash());
+}
+
+static bool header_matches(const ThumbnailFileHeader& header, const struct stat& st)
+{
+    return !memcmp(header.magic, "!Thm", 4)
+        && header.version == thumbnail_file_version
+        && header.width == thumbnail_size
+        && header.height == thumbnail_size
+        && header.inode == st.st_ino
+        && header.size == (dword)st.st_size
+        && header.mtime == st.st_mtime;
+}
+
+RetainPtr<GraphicsBitmap> load_stored_thumbnail(const String& path, const struct stat& st)
+{
+    auto directory = thumbnail_directory(false);
+    if (directory.is_null())
+        return nullptr;
+    auto mapped_file_path = thumbnail_file_path(directory, path);
+    MappedFile mapped_file(mapped_file_path);
+    if (!mapped_file.is_valid())
+        return nullptr;
+
+    size_t pixels_size = thumbnail_size * thumbnail_size * sizeof(RGBA32);
+    if (mapped_file.size() < sizeof(ThumbnailFileHeader))
+        return nullptr;
+    auto* data = (const byte*)mapped_file.pointer();
+    auto& header = *reinterpret_cast<const ThumbnailFileHeader*>(data);
+    if (!header_matches(header, st))
+        return nullptr;
+    if (mapped_file.size() != sizeof(ThumbnailFileHeader) + header.path_length + pixels_size)
+        return nullptr;
+    auto* stored_path = (const char*)(data + sizeof(ThumbnailFileHeader));
+    if (header.path_length != path.length() || memcmp(stored_path, path.characters(), path.length()))
+        return nullptr;
+
+    auto format = (GraphicsBitmap::Format)header.format;
+    if (format != GraphicsBitmap::Format::RGB32 && format != GraphicsBitmap::Format::RGBA32)
+        return nullptr;
+    auto thumbnail = GraphicsBitmap::create(format, { thumbnail_size, thumbnail_size });
+    memcpy(thumbnail->scanline(0), stored_path + header.path_length, pixels_size);
+    // Pruning goes by modification time, so touching a thumbnail on every use makes it evict the least recently used.
+    utime(mapped_file_path.characters(), nullptr);
+    return thumbnail;
+}
+
+// A stored thumbnail is stale once its image is gone or has changed, or if it's a temporary left behind by a crash.
+static bool is_stale(const char* name, const String& file_path)
+{
+    if (strchr(name, '.'))
+        return true;
+    MappedFile mapped_file(file_path);
+    if (!mapped_file.is_valid() || mapped_file.size() < sizeof(ThumbnailFileHeader))
+        return true;
+    auto* data = (const byte*)mapped_file.pointer();
+    auto& header = *reinterpret_cast<const ThumbnailFileHeader*>(data);
+    if (mapped_file.size() < sizeof(ThumbnailFileHeader) + header.path_length)
+        return true;
+    String path((const char*)(data + sizeof(ThumbnailFileHeader)), header.path_length);
+    struct stat st;
+    if (stat(path.characters(), &st) < 0)
+        return true;
+    return !header_matches(header, st);
+}
+
+static void prune_thumbnails(const String& directory)
+{
+    DIR* dirp = opendir(directory.characters());
+    if (!dirp)
+        return;
+    struct StoredThumbnail {
+        String file_path;
+        time_t mtime;
+    };
+    Vector<StoredThumbnail> thumbnails;
+    struct stat st;
+    while (auto* de = readdir_with_stat(dirp, &st)) {
+        // Anything that isn't a thumbnail file of ours is left alone.
+        if (!S_ISREG(st.st_mode) || st.st_uid != getuid())
+            continue;
+        thumbnails.append({ String::format("%s/%s", directory.characters(), de->d_name), st.st_mtime });
+    }
+    closedir(dirp);
+    if (thumbnails.size() <= max_stored_thumbnails)
+        return;
+
+    // Stale thumbnails go first, since they'll never be used again. Then the least recently used ones.
+    Vector<StoredThumbnail> fresh_thumbnails;
+    for (auto& thumbnail : thumbnails) {
+        auto* name = thumbnail.file_path.characters() + directory.length() + 1;
+        if (is_stale(name, thumbnail.file_path))
+            unlink(thumbnail.file_path.characters());
+        else
+            fresh_thumbnails.append(move(thumbnail));
+    }
+    int excess = fresh_thumbnails.size() - max_stored_thumbnails * 3 / 4;
+    if (excess <= 0)
+        return;
+    quick_sort(fresh_thumbnails.begin(), fresh_thumbnails.end(), [](auto& a, auto& b) {
+        return a.mtime < b.mtime;
+    });
+    for (int i = 0; i < excess; ++i)
+        unlink(fresh_thumbnails[i].file_path.characters());
+}
+
+void store_thumbnail(const String& path, const struct stat& st, const GraphicsBitmap& thumbnail)
+{
+    ASSERT(thumbnail.width() == thumbnail_size && thumbnail.height() == thumbnail_size);
+    if (path.length() > 0xffff)
+        return;
+
+    auto directory = thumbnail_directory(true);
+    if (directory.is_null())
+        return;
+
+    ThumbnailFileHeader header;
+    memset(&header, 0, sizeof(ThumbnailFileHeader));
+    memcpy(header.magic, "!Thm", 4);
+    header.version = thumbnail_file_version;
+    header.format = (byte)thumbnail.format();
+    header.width = thumbnail_size;
+    header.height = thumbnail_size;
+    header.path_length = path.length();
+    header.inode = st.st_ino;
+    header.size = st.st_size;
+    header.mtime = st.st_mtime;
+
+    size_t pixels_size = thumbnail_size * thumbnail_size * sizeof(RGBA32);
+    Vector<byte> buffer;
+    buffer.ensure_capacity(sizeof(ThumbnailFileHeader) + path.length() + pixels_size);
+    buffer.append((const byte*)&header, sizeof(ThumbnailFileHeader));
+    buffer.append((const byte*)path.characters(), path.length());
+    buffer.append((const byte*)thumbnail.scanline(0), pixels_size);
+
+    // Write to a fresh temporary and rename it into place, so that another FileManager
+    // never maps a half-written thumbnail. O_EXCL makes sure the temporary is a new file of our own,
+    // and a name that's taken (by the other worker thread, or left over from a crash) is just skipped.
+    auto file_path = thumbnail_file_path(directory, path);
+    String temporary_path;
+    int fd = -1;
+    for (int attempt = 0; fd < 0 && attempt < 8; ++attempt) {
+        temporary_path = String::format("%s.%d.%d", file_path.characters(), gettid(), attempt);
+        fd = open(temporary_path.characters(), O_WRONLY | O_CREAT | O_EXCL | O_NOFOLLOW, 0600);
+        if (fd < 0 && errno != EEXIST)
+            return;
+    }
+    if (fd < 0)
+        return;
+    ssize_t nwritten = write(fd, buffer.data(), buffer.size());
+    close(fd);
+    if (nwritten != (ssize_t)buffer.size() || rename(temporary_path.characters(), file_path.characters()) < 0)
+        unlink(temporary_path.characters());
+
+    // The first store checks the size right away, so a store that grew while FileManager wasn't running gets trimmed too.
+    LOCKER(s_prune_lock);
+    if (s_stores_until_prune-- == 0) {
+        prune_thumbnails(directory);
+        s_stores_until_prune = stores_between_prunes - 1;
+    }
+}
+
+Retained<GraphicsBitmap> generate_thumbnail(const GraphicsBitmap& source)
+{
+    auto thumbnail = GraphicsBitmap::create(source.format(), { thumbnail_size, thumbnail_size });
+    int source_width = source.width();
+    int source_height = source.height();
+
+    // Column 'x' of the thumbnail covers source columns [column_start[x], column_start[x + 1]).
+    // When the source is narrower than the thumbnail, a span is widened to its single nearest column.
+    int column_start[thumbnail_size + 1];
+    for (int x = 0; x <= thumbnail_size; ++x)
+        column_start[x] = x * source_width / thumbnail_size;
+
+    dword sums[thumbnail_size][4];
+    for (int y = 0; y < thumbnail_size; ++y) {
+        int first_row = y * source_height / thumbnail_size;
+        int end_row = max(first_row + 1, (y + 1) * source_height / thumbnail_size);
+        memset(sums, 0, sizeof(sums));
+        for (int source_y = first_row; source_y < end_row; ++source_y) {
+            auto* source_row = source.scanline(source_y);
+            for (int x = 0; x < thumbnail_size; ++x) {
+                int end_column = max(column_start[x] + 1, column_start[x + 1]);
+                for (int source_x = column_start[x]; source_x < end_column; ++source_x) {
+                    RGBA32 pixel = source_row[source_x];
+                    sums[x][0] += (pixel >> 24) & 0xff;
+                    sums[x][1] += (pixel >> 16) & 0xff;
+                    sums[x][2] += (pixel >> 8) & 0xff;
+                    sums[x][3] += pixel & 0xff;
+                }
+            }
+        }
+        auto* thumbnail_row = thumbnail->scanline(y);
+        for (int x = 0; x < thumbnail_size; ++x) {
+            dword count = (end_row - first_row) * max(1, column_start[x + 1] - column_start[x]);
+            thumbnail_row[x] = (sums[x][0] / count) << 24
+                | (sums[x][1] / count) << 16
+                | (sums[x][2] / count) << 8
+                | (sums[x][3] / count);
+        }
+    }
+    return thumbnail;
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <AK/AKString.h>
+#include <AK/RetainPtr.h>
+#include <SharedGraphics/GraphicsBitmap.h>
+#include <sys/stat.h>
+
+// Thumbnails persist in ~/.cache/thumbnails, one file per image, so they survive FileManager restarts
+// and are shared between FileManager windows. A stored thumbnail is only used if the image's
+// inode, size and modification time still match what they were when it was generated.
+// The store is capped, and pruned of stale and least recently used thumbnails as it fills up.
+
+static const int thumbnail_size = 32;
+
+RetainPtr<GraphicsBitmap> load_stored_thumbnail(const String& path, const struct stat&);
+void store_thumbnail(const String& path, const struct stat&, const GraphicsBitmap&);
+
+// Box-filters 'source' down to a thumbnail_size square. Along a dimension where the source is
+// smaller than the thumbnail, source pixels are repeated instead (nearest neighbor).
+Retained<GraphicsBitmap> generate_thumbnail(const GraphicsBitmap& source);
@@ -95,6 +95,7 @@ FontEditorWidget::FontEditorWidget(const String& path, RetainPtr<Font>&& edited_
         m_edited_font->set_fixed_width(is_checked);
         width_textbox->set_text(String::format("%u", m_edited_font->glyph_width(m_glyph_map_widget->selected_glyph())));
         m_glyph_editor_widget->update();
+        m_glyph_map_widget->update();
         update_demo();
     };
 
@@ -104,6 +105,7 @@ FontEditorWidget::FontEditorWidget(const String& path, RetainPtr<Font>&& edited_
         if (ok) {
             m_edited_font->set_glyph_width(m_glyph_map_widget->selected_glyph(), width);
             m_glyph_editor_widget->update();
+            m_glyph_map_widget->update();
             update_demo();
         }
     };
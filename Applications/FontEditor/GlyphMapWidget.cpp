@@ -6,6 +6,7 @@ GlyphMapWidget::GlyphMapWidget(Font& mutable_font, GWidget* parent)
     , m_font(mutable_font)
 {
     set_relative_rect({ 0, 0, preferred_width(), preferred_height() });
+    set_paint_cache_enabled(true);
 }
 
 GlyphMapWidget::~GlyphMapWidget()
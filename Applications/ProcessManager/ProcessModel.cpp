@@ -1,7 +1,8 @@
 #include "ProcessModel.h"
-#include <LibGUI/GFile.h>
 #include <fcntl.h>
 #include <stdio.h>
+#include <string.h>
+#include <unistd.h>
 #include <pwd.h>
 
 ProcessModel::ProcessModel()
@@ -15,10 +16,17 @@ ProcessModel::ProcessModel()
     m_high_priority_icon = GraphicsBitmap::load_from_file("/res/icons/highpriority16.png");
     m_low_priority_icon = GraphicsBitmap::load_from_file("/res/icons/lowpriority16.png");
     m_normal_priority_icon = GraphicsBitmap::load_from_file("/res/icons/normalpriority16.png");
+
+    m_statistics_fd = open("/proc/all_binary", O_RDONLY);
+    if (m_statistics_fd < 0) {
+        perror("ProcessManager: Failed to open /proc/all_binary");
+        exit(1);
+    }
 }
 
 ProcessModel::~ProcessModel()
 {
+    close(m_statistics_fd);
 }
 
 int ProcessModel::row_count(const GModelIndex&) const
@@ -63,9 +71,12 @@ GModel::ColumnMetadata ProcessModel::column_metadata(int column) const
     }
 }
 
-static String pretty_byte_size(size_t size)
+static GVariant pretty_byte_size(size_t size)
 {
-    return String::format("%uK", size / 1024);
+    // Short enough to live inside the GVariant, so painting the table doesn't allocate for it.
+    char buffer[16];
+    int length = snprintf(buffer, sizeof(buffer), "%uK", size / 1024);
+    return GVariant(buffer, length);
 }
 
 GVariant ProcessModel::data(const GModelIndex& index, Role role) const
@@ -123,14 +134,44 @@ GVariant ProcessModel::data(const GModelIndex& index, Role role) const
     return { };
 }
 
+bool ProcessModel::read_statistics()
+{
+    // ProcFS generates the whole snapshot on the first read after a rewind, so with a big
+    // enough buffer this is a single read() plus the one that returns EOF.
+    if (lseek(m_statistics_fd, 0, SEEK_SET) < 0)
+        return false;
+    m_statistics_buffer.clear_with_capacity();
+    for (;;) {
+        int offset = m_statistics_buffer.size();
+        m_statistics_buffer.resize(max(offset * 2, 4096));
+        ssize_t nread = read(m_statistics_fd, m_statistics_buffer.data() + offset, m_statistics_buffer.size() - offset);
+        if (nread < 0)
+            return false;
+        m_statistics_buffer.resize(offset + nread);
+        if (nread == 0)
+            break;
+    }
+    if (m_statistics_buffer.size() < (int)sizeof(ProcessStatisticsHeader))
+        return false;
+    auto& header = *(const ProcessStatisticsHeader*)m_statistics_buffer.data();
+    if (header.version != PROCESS_STATISTICS_VERSION || header.record_size != sizeof(ProcessStatistics))
+        return false;
+    return m_statistics_buffer.size() == (int)(sizeof(ProcessStatisticsHeader) + header.process_count * sizeof(ProcessStatistics));
+}
+
 void ProcessModel::update()
 {
-    GFile file("/proc/all");
-    if (!file.open(GIODevice::ReadOnly)) {
-        fprintf(stderr, "ProcessManager: Failed to open /proc/all: %s\n", file.error_string());
+    if (!read_statistics()) {
+        fprintf(stderr, "ProcessManager: Failed to read /proc/all_binary\n");
         exit(1);
         return;
     }
+    auto& header = *(const ProcessStatisticsHeader*)m_statistics_buffer.data();
+    auto* records = (const ProcessStatistics*)(m_statistics_buffer.data() + sizeof(ProcessStatisticsHeader));
+
+    // If no process has come or gone since last time, the pid list is still good.
+    bool same_processes = header.generation == m_statistics_generation && header.process_count == m_processes.size();
+    m_statistics_generation = header.generation;
 
     unsigned last_sum_nsched = 0;
     for (auto& it : m_processes)
@@ -138,66 +179,66 @@ void ProcessModel::update()
 
     HashTable<pid_t> live_pids;
     unsigned sum_nsched = 0;
-    for (;;) {
-        auto line = file.read_line(1024);
-        if (line.is_empty())
-            break;
-        auto parts = String((const char*)line.pointer(), line.size() - 1, Chomp).split(',');
-        if (parts.size() < 17)
-            break;
-        bool ok;
-        pid_t pid = parts[0].to_uint(ok);
-        ASSERT(ok);
-        unsigned nsched = parts[1].to_uint(ok);
-        ASSERT(ok);
-        ProcessState state;
-        state.pid = pid;
-        state.nsched = nsched;
-        unsigned uid = parts[5].to_uint(ok);
-        ASSERT(ok);
-        {
-            auto it = m_usernames.find((uid_t)uid);
-            if (it != m_usernames.end())
-                state.user = String::format("%s", (*it).value.characters());
+    for (dword i = 0; i < header.process_count; ++i) {
+        auto& record = records[i];
+        pid_t pid = record.pid;
+        sum_nsched += record.times_scheduled;
+
+        bool is_new = !m_processes.contains(pid);
+        if (is_new)
+            m_processes.set(pid, make<Process>());
+        auto it = m_processes.find(pid);
+        ASSERT(it != m_processes.end());
+        auto& process = *(*it).value;
+        process.previous_nsched = process.current_state.nsched;
+
+        auto& state = process.current_state;
+        auto& previous_record = process.statistics;
+        state.nsched = record.times_scheduled;
+        state.linear = record.amount_virtual;
+        state.physical = record.amount_resident;
+        if (is_new || record.uid != previous_record.uid) {
+            auto jt = m_usernames.find((uid_t)record.uid);
+            if (jt != m_usernames.end())
+                state.user = (*jt).value;
             else
-                state.user = String::format("%u", uid);
+                state.user = String::format("%u", record.uid);
         }
-        state.priority = parts[16];
-        state.state = parts[7];
-        state.name = parts[11];
-        state.linear = parts[12].to_uint(ok);
-        ASSERT(ok);
-        state.physical = parts[13].to_uint(ok);
-        ASSERT(ok);
-        sum_nsched += nsched;
-        {
-            auto it = m_processes.find(pid);
-            if (it == m_processes.end())
-                m_processes.set(pid, make<Process>());
+        if (is_new || strcmp(record.state, previous_record.state))
+            state.state = record.state;
+        if (is_new || strcmp(record.priority, previous_record.priority))
+            state.priority = record.priority;
+        if (is_new || strcmp(record.name, previous_record.name))
+            state.name = record.name;
+        if (is_new) {
+            state.pid = pid;
+            process.previous_nsched = state.nsched;
         }
-        auto it = m_processes.find(pid);
-        ASSERT(it != m_processes.end());
-        (*it).value->previous_state = (*it).value->current_state;
-        (*it).value->current_state = state;
+        previous_record = record;
 
-        live_pids.set(pid);
+        if (!same_processes)
+            live_pids.set(pid);
     }
 
-    m_pids.clear();
-    Vector<pid_t> pids_to_remove;
-    for (auto& it : m_processes) {
-        if (!live_pids.contains(it.key)) {
-            pids_to_remove.append(it.key);
-            continue;
+    if (!same_processes) {
+        m_pids.clear();
+        Vector<pid_t> pids_to_remove;
+        for (auto& it : m_processes) {
+            if (!live_pids.contains(it.key)) {
+                pids_to_remove.append(it.key);
+                continue;
+            }
+            m_pids.append(it.key);
         }
+        for (auto pid : pids_to_remove)
+            m_processes.remove(pid);
+    }
 
+    for (auto& it : m_processes) {
         auto& process = *it.value;
-        dword nsched_diff = process.current_state.nsched - process.previous_state.nsched;
+        dword nsched_diff = process.current_state.nsched - process.previous_nsched;
         process.current_state.cpu_percent = ((float)nsched_diff * 100) / (float)(sum_nsched - last_sum_nsched);
-        m_pids.append(it.key);
     }
-    for (auto pid : pids_to_remove)
-        m_processes.remove(pid);
 
     did_update();
 }
@@ -4,6 +4,7 @@
 #include <AK/HashMap.h>
 #include <AK/Vector.h>
 #include <LibGUI/GModel.h>
+#include <Kernel/ProcessStatistics.h>
 #include <unistd.h>
 
 class ProcessModel final : public GModel {
@@ -34,6 +35,8 @@ public:
 private:
     ProcessModel();
 
+    bool read_statistics();
+
     struct ProcessState {
         pid_t pid;
         unsigned nsched;
@@ -48,12 +51,17 @@ private:
 
     struct Process {
         ProcessState current_state;
-        ProcessState previous_state;
+        unsigned previous_nsched { 0 };
+        // The record current_state was built from, so unchanged processes can skip rebuilding their strings.
+        ProcessStatistics statistics;
     };
 
     HashMap<uid_t, String> m_usernames;
     HashMap<pid_t, OwnPtr<Process>> m_processes;
     Vector<pid_t> m_pids;
+    int m_statistics_fd { -1 };
+    Vector<byte> m_statistics_buffer;
+    dword m_statistics_generation { 0 };
     RetainPtr<GraphicsBitmap> m_generic_process_icon;
     RetainPtr<GraphicsBitmap> m_high_priority_icon;
     RetainPtr<GraphicsBitmap> m_low_priority_icon;
@@ -2,6 +2,7 @@
 #include <LibGUI/GWidget.h>
 #include <LibGUI/GBoxLayout.h>
 #include <LibGUI/GApplication.h>
+#include <LibGUI/GEventLoop.h>
 #include <LibGUI/GToolBar.h>
 #include <LibGUI/GMenuBar.h>
 #include <LibGUI/GAction.h>
@@ -15,6 +16,9 @@ int main(int argc, char** argv)
 {
     GApplication app(argc, argv);
 
+    // The process table and the memory stats both refresh once a second. A little slack lets them share one wakeup.
+    GEventLoop::set_timer_slack(100);
+
     auto* widget = new GWidget;
     widget->set_layout(make<GBoxLayout>(Orientation::Vertical));
 
@@ -8,7 +8,6 @@
 #include <LibGUI/GTextEditor.h>
 #include <LibGUI/GAction.h>
 #include <LibGUI/GFontDatabase.h>
-#include <LibGUI/GFile.h>
 #include <AK/StringBuilder.h>
 #include <unistd.h>
 #include <stdio.h>
@@ -35,13 +34,10 @@ int main(int argc, char** argv)
     String path = "/tmp/TextEditor.save.txt";
     if (argc >= 2) {
         path = argv[1];
-        GFile file(path);
-
-        if (!file.open(GIODevice::ReadOnly)) {
-            fprintf(stderr, "Opening %s: %s\n", path.characters(), file.error_string());
+        if (!text_editor->read_from_file(path)) {
+            fprintf(stderr, "Opening %s failed\n", path.characters());
             return 1;
         }
-        text_editor->set_text(String::from_byte_buffer(file.read_all()));
     }
 
     auto new_action = GAction::create("New document", { Mod_Ctrl, Key_N }, GraphicsBitmap::load_from_file("/res/icons/16x16/new.png"), [] (const GAction&) {
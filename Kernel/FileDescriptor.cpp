@@ -115,16 +115,8 @@ bool addition_would_overflow(off_t a, off_t b)
     return (ua + b) > OFF_T_MAX;
 }
 
-KResult FileDescriptor::fstat(stat& buffer)
+static void fill_stat(const InodeMetadata& metadata, stat& buffer)
 {
-    ASSERT(!is_fifo());
-    if (!m_inode && !m_device)
-        return KResult(-EBADF);
-
-    auto metadata = this->metadata();
-    if (!metadata.is_valid())
-        return KResult(-EIO);
-
     buffer.st_rdev = encoded_device(metadata.major_device, metadata.minor_device);
     buffer.st_ino = metadata.inode.index();
     buffer.st_mode = metadata.mode;
@@ -138,6 +130,19 @@ KResult FileDescriptor::fstat(stat& buffer)
     buffer.st_atime = metadata.atime;
     buffer.st_mtime = metadata.mtime;
     buffer.st_ctime = metadata.ctime;
+}
+
+KResult FileDescriptor::fstat(stat& buffer)
+{
+    ASSERT(!is_fifo());
+    if (!m_inode && !m_device)
+        return KResult(-EBADF);
+
+    auto metadata = this->metadata();
+    if (!metadata.is_valid())
+        return KResult(-EIO);
+
+    fill_stat(metadata, buffer);
     return KSuccess;
 }
 
@@ -298,6 +303,51 @@ ssize_t FileDescriptor::get_dir_entries(byte* buffer, ssize_t size)
     return stream.offset();
 }
 
+ssize_t FileDescriptor::get_dir_entries_with_stat(byte* buffer, ssize_t size)
+{
+    auto metadata = this->metadata();
+    if (!metadata.is_valid())
+        return -EIO;
+    if (!metadata.is_directory())
+        return -ENOTDIR;
+
+    struct Entry {
+        String name;
+        InodeIdentifier inode;
+        byte file_type;
+    };
+    Vector<Entry> entries;
+    ssize_t size_needed = 0;
+    VFS::the().traverse_directory_inode(*m_inode, [&] (auto& entry) {
+        entries.append({ String(entry.name, entry.name_length), entry.inode, entry.file_type });
+        size_needed += sizeof(dword) + sizeof(byte) + sizeof(dword) + entry.name_length + sizeof(stat);
+        return true;
+    });
+
+    if (size < size_needed)
+        return -ERANGE;
+
+    // Same records as get_dir_entries(), each followed by the entry's stat. The inodes are looked up
+    // only after the traversal, since that holds the directory inode's lock.
+    auto temp_buffer = ByteBuffer::create_uninitialized(size_needed);
+    BufferStream stream(temp_buffer);
+    for (auto& entry : entries) {
+        stream << (dword)entry.inode.index();
+        stream << (byte)entry.file_type;
+        stream << (dword)entry.name.length();
+        stream << entry.name;
+        stat entry_stat;
+        memset(&entry_stat, 0, sizeof(entry_stat));
+        entry_stat.st_ino = entry.inode.index();
+        if (auto inode = VFS::the().get_inode(entry.inode))
+            fill_stat(inode->metadata(), entry_stat);
+        stream << ByteBuffer::wrap(&entry_stat, sizeof(entry_stat));
+    }
+
+    memcpy(buffer, temp_buffer.pointer(), stream.offset());
+    return stream.offset();
+}
+
 bool FileDescriptor::is_tty() const
 {
     return m_device && m_device->is_tty();
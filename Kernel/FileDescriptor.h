@@ -40,6 +40,7 @@ public:
     bool can_write(Process&);
 
     ssize_t get_dir_entries(byte* buffer, ssize_t);
+    ssize_t get_dir_entries_with_stat(byte* buffer, ssize_t);
 
     ByteBuffer read_entire_file(Process&);
 
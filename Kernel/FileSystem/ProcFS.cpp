@@ -9,6 +9,9 @@
 #include "Console.h"
 #include "Scheduler.h"
 #include <Kernel/PCI.h>
+#include <Kernel/ProcessStatistics.h>
+#include <Kernel/Net/NetworkAdapter.h>
+#include <Kernel/Net/NetworkStatistics.h>
 #include <AK/StringBuilder.h>
 #include <LibC/errno_numbers.h>
 
@@ -16,6 +19,7 @@ enum ProcParentDirectory {
     PDI_AbstractRoot = 0,
     PDI_Root,
     PDI_Root_sys,
+    PDI_Root_net,
     PDI_PID,
     PDI_PID_fd,
 };
@@ -31,6 +35,7 @@ enum ProcFileType {
     FI_Root_df,
     FI_Root_kmalloc,
     FI_Root_all,
+    FI_Root_all_binary,
     FI_Root_memstat,
     FI_Root_summary,
     FI_Root_cpuinfo,
@@ -39,8 +44,13 @@ enum ProcFileType {
     FI_Root_pci,
     FI_Root_self, // symlink
     FI_Root_sys, // directory
+    FI_Root_net, // directory
     __FI_Root_End,
 
+    __FI_Root_net_Start,
+    FI_Root_net_stats,
+    __FI_Root_net_End,
+
     FI_PID,
 
     __FI_PID_Start,
@@ -106,6 +116,8 @@ static inline InodeIdentifier to_parent_id(const InodeIdentifier& identifier)
         return { identifier.fsid(), FI_Root };
     case PDI_Root_sys:
         return { identifier.fsid(), FI_Root_sys };
+    case PDI_Root_net:
+        return { identifier.fsid(), FI_Root_net };
     case PDI_PID:
         return to_identifier(identifier.fsid(), PDI_Root, to_pid(identifier), FI_PID);
     case PDI_PID_fd:
@@ -146,6 +158,7 @@ static inline bool is_directory(const InodeIdentifier& identifier)
     switch (proc_file_type) {
     case FI_Root:
     case FI_Root_sys:
+    case FI_Root_net:
     case FI_PID:
     case FI_PID_fd:
         return true;
@@ -249,6 +262,32 @@ ByteBuffer procfs$pci(InodeIdentifier)
     return builder.to_byte_buffer();
 }
 
+ByteBuffer procfs$net_stats(InodeIdentifier)
+{
+    StringBuilder builder;
+    auto append_protocol = [&builder] (const char* name, const ProtocolStatistics& statistics) {
+        builder.appendf("%s: received=%u, sent=%u, dropped=%u\n", name, statistics.packets_received, statistics.packets_sent, statistics.packets_dropped);
+    };
+    auto& statistics = NetworkStatistics::the();
+    append_protocol("ethernet", statistics.ethernet);
+    append_protocol("arp", statistics.arp);
+    append_protocol("ipv4", statistics.ipv4);
+    append_protocol("icmp", statistics.icmp);
+    append_protocol("udp", statistics.udp);
+    append_protocol("tcp", statistics.tcp);
+
+    NetworkAdapter::for_each([&builder] (NetworkAdapter& adapter) {
+        builder.appendf("%s: packets_in=%u, bytes_in=%u, packets_out=%u, bytes_out=%u, dropped=%u\n",
+            adapter.class_name(),
+            adapter.packets_in(),
+            adapter.bytes_in(),
+            adapter.packets_out(),
+            adapter.bytes_out(),
+            adapter.packets_dropped());
+    });
+    return builder.to_byte_buffer();
+}
+
 ByteBuffer procfs$pid_vmo(InodeIdentifier identifier)
 {
     auto handle = ProcessInspectionHandle::from_pid(to_pid(identifier));
@@ -595,6 +634,47 @@ ByteBuffer procfs$all(InodeIdentifier)
     return builder.to_byte_buffer();
 }
 
+ByteBuffer procfs$all_binary(InodeIdentifier)
+{
+    InterruptDisabler disabler;
+    Vector<Process*> processes;
+    processes.append(Scheduler::colonel());
+    processes.append(Process::all_processes());
+    auto buffer = ByteBuffer::create_zeroed(sizeof(ProcessStatisticsHeader) + processes.size() * sizeof(ProcessStatistics));
+    auto& header = *(ProcessStatisticsHeader*)buffer.pointer();
+    header.version = PROCESS_STATISTICS_VERSION;
+    header.record_size = sizeof(ProcessStatistics);
+    header.process_count = processes.size();
+    header.generation = g_processes_generation;
+    auto* records = (ProcessStatistics*)(buffer.pointer() + sizeof(ProcessStatisticsHeader));
+    // The buffer is zeroed, so copying at most sizeof(field) - 1 characters always leaves a terminator.
+    auto copy_string = [] (char* field, size_t field_size, const char* string) {
+        strncpy(field, string, field_size - 1);
+    };
+    for (int i = 0; i < processes.size(); ++i) {
+        auto& process = *processes[i];
+        auto& record = records[i];
+        record.pid = process.pid();
+        record.times_scheduled = process.main_thread().times_scheduled(); // FIXME(Thread): Bill all scheds to the process
+        record.pgid = process.pgid();
+        record.tty_pgid = process.tty() ? process.tty()->pgid() : 0;
+        record.sid = process.sid();
+        record.uid = process.uid();
+        record.gid = process.gid();
+        record.ppid = process.ppid();
+        record.file_descriptor_count = process.number_of_open_file_descriptors();
+        record.amount_virtual = process.amount_virtual();
+        record.amount_resident = process.amount_resident();
+        record.amount_shared = process.amount_shared();
+        record.ticks = process.main_thread().ticks(); // FIXME(Thread): Bill all ticks to the process
+        copy_string(record.state, sizeof(record.state), to_string(process.state()));
+        copy_string(record.priority, sizeof(record.priority), to_string(process.priority()));
+        copy_string(record.tty, sizeof(record.tty), process.tty() ? process.tty()->tty_name().characters() : "notty");
+        copy_string(record.name, sizeof(record.name), process.name().characters());
+    }
+    return buffer;
+}
+
 ByteBuffer procfs$inodes(InodeIdentifier)
 {
     extern HashTable<Inode*>& all_inodes();
@@ -841,6 +921,7 @@ InodeMetadata ProcFSInode::metadata() const
         break;
     case FI_Root:
     case FI_Root_sys:
+    case FI_Root_net:
     case FI_PID:
     case FI_PID_fd:
         metadata.mode = 040777;
@@ -939,6 +1020,13 @@ bool ProcFSInode::traverse_as_directory(Function<bool(const FS::DirectoryEntry&)
         }
         break;
 
+    case FI_Root_net:
+        for (auto& entry : fs().m_entries) {
+            if (entry.proc_file_type > __FI_Root_net_Start && entry.proc_file_type < __FI_Root_net_End)
+                callback({ entry.name, strlen(entry.name), to_identifier(fsid(), PDI_Root_net, 0, (ProcFileType)entry.proc_file_type), 0 });
+        }
+        break;
+
     case FI_PID: {
         auto handle = ProcessInspectionHandle::from_pid(pid);
         if (!handle)
@@ -1020,6 +1108,16 @@ InodeIdentifier ProcFSInode::lookup(const String& name)
         return { };
     }
 
+    if (proc_file_type == FI_Root_net) {
+        for (auto& entry : fs().m_entries) {
+            if (entry.proc_file_type > __FI_Root_net_Start && entry.proc_file_type < __FI_Root_net_End) {
+                if (!strcmp(entry.name, name.characters()))
+                    return to_identifier(fsid(), PDI_Root_net, 0, (ProcFileType)entry.proc_file_type);
+            }
+        }
+        return { };
+    }
+
     if (proc_file_type == FI_PID) {
         auto handle = ProcessInspectionHandle::from_pid(to_pid(identifier()));
         if (!handle)
@@ -1138,6 +1236,7 @@ ProcFS::ProcFS()
     m_entries[FI_Root_df] = { "df", FI_Root_df, procfs$df };
     m_entries[FI_Root_kmalloc] = { "kmalloc", FI_Root_kmalloc, procfs$kmalloc };
     m_entries[FI_Root_all] = { "all", FI_Root_all, procfs$all };
+    m_entries[FI_Root_all_binary] = { "all_binary", FI_Root_all_binary, procfs$all_binary };
     m_entries[FI_Root_memstat] = { "memstat", FI_Root_memstat, procfs$memstat };
     m_entries[FI_Root_summary] = { "summary", FI_Root_summary, procfs$summary };
     m_entries[FI_Root_cpuinfo] = { "cpuinfo", FI_Root_cpuinfo, procfs$cpuinfo};
@@ -1146,6 +1245,9 @@ ProcFS::ProcFS()
     m_entries[FI_Root_self] = { "self", FI_Root_self, procfs$self };
     m_entries[FI_Root_pci] = { "pci", FI_Root_pci, procfs$pci };
     m_entries[FI_Root_sys] = { "sys", FI_Root_sys };
+    m_entries[FI_Root_net] = { "net", FI_Root_net };
+
+    m_entries[FI_Root_net_stats] = { "stats", FI_Root_net_stats, procfs$net_stats };
 
     m_entries[FI_PID_vm] = { "vm", FI_PID_vm, procfs$pid_vm };
     m_entries[FI_PID_vmo] = { "vmo", FI_PID_vmo, procfs$pid_vmo };
@@ -0,0 +1,127 @@
+#include <Kernel/Net/ARPCache.h>
+#include <Kernel/Net/NetworkAdapter.h>
+#include <Kernel/i8253.h>
+#include <Kernel/system.h>
+
+//#define ARP_DEBUG
+
+static const dword entry_lifetime = 300 * TICKS_PER_SECOND;
+static const dword request_timeout = 1 * TICKS_PER_SECOND;
+static const int max_entries = 256;
+static const int max_pending_packets_per_entry = 8;
+
+ARPCache& ARPCache::the()
+{
+    static ARPCache* the;
+    if (!the)
+        the = new ARPCache;
+    return *the;
+}
+
+bool ARPCache::lookup(const IPv4Address& address, MACAddress& mac_address)
+{
+    LOCKER(m_entries.lock());
+    auto it = m_entries.resource().find(address);
+    if (it == m_entries.resource().end())
+        return false;
+    auto& entry = (*it).value;
+    if (!entry.is_resolved)
+        return false;
+    if (entry.expiration_time <= (dword)system.uptime) {
+#ifdef ARP_DEBUG
+        kprintf("ARPCache: Entry for %s went stale\n", address.to_string().characters());
+#endif
+        m_entries.resource().remove(it);
+        return false;
+    }
+    mac_address = entry.mac_address;
+    return true;
+}
+
+void ARPCache::update(const IPv4Address& address, const MACAddress& mac_address)
+{
+    NetworkAdapter* adapter = nullptr;
+    Vector<PendingPacket> pending_packets;
+    {
+        LOCKER(m_entries.lock());
+        auto& entries = m_entries.resource();
+        if (!entries.contains(address)) {
+            // FIXME: Protect against ARP spamming more cleverly than this.
+            if ((int)entries.size() >= max_entries)
+                entries.remove_one_randomly();
+            entries.set(address, Entry());
+        }
+        auto& entry = (*entries.find(address)).value;
+        entry.mac_address = mac_address;
+        entry.is_resolved = true;
+        entry.expiration_time = system.uptime + entry_lifetime;
+        adapter = entry.adapter;
+        pending_packets = move(entry.pending_packets);
+    }
+
+#ifdef ARP_DEBUG
+    kprintf("ARPCache: %s is at %s, sending %d pending packet(s)\n", address.to_string().characters(), mac_address.to_string().characters(), pending_packets.size());
+#endif
+
+    // Send these without holding the lock, since the adapter may end up back in here.
+    for (auto& packet : pending_packets)
+        adapter->send_ipv4(mac_address, packet.destination, packet.protocol, move(packet.payload), packet.payload_checksum_offset);
+}
+
+void ARPCache::enqueue(NetworkAdapter& adapter, const IPv4Address& next_hop, const IPv4Address& destination, IPv4Protocol protocol, ByteBuffer&& payload, int payload_checksum_offset)
+{
+    bool should_send_request = false;
+    bool is_resolved = false;
+    MACAddress mac_address;
+    {
+        LOCKER(m_entries.lock());
+        auto& entries = m_entries.resource();
+        if (!entries.contains(next_hop)) {
+            if ((int)entries.size() >= max_entries)
+                entries.remove_one_randomly();
+            entries.set(next_hop, Entry());
+        }
+        auto& entry = (*entries.find(next_hop)).value;
+        if (entry.is_resolved && entry.expiration_time > (dword)system.uptime) {
+            // It got resolved after the caller's lookup(), so there's nothing to wait for.
+            is_resolved = true;
+            mac_address = entry.mac_address;
+        } else {
+            if (entry.is_resolved) {
+                // The binding went stale, start over.
+                entry = Entry();
+            }
+            if (entry.expiration_time <= (dword)system.uptime) {
+                if (!entry.pending_packets.is_empty()) {
+                    kprintf("ARPCache: No response from %s, dropping %d packet(s)\n", next_hop.to_string().characters(), entry.pending_packets.size());
+                    entry.pending_packets.clear();
+                }
+                entry.expiration_time = system.uptime + request_timeout;
+                should_send_request = true;
+            }
+            if (entry.pending_packets.size() >= max_pending_packets_per_entry)
+                entry.pending_packets.take_first();
+            entry.adapter = &adapter;
+            entry.pending_packets.append({ destination, protocol, move(payload), payload_checksum_offset });
+        }
+    }
+
+    // Like update(), send without holding the lock.
+    if (is_resolved)
+        adapter.send_ipv4(mac_address, destination, protocol, move(payload), payload_checksum_offset);
+    else if (should_send_request)
+        adapter.send_arp_request(next_hop);
+}
+
+void ARPCache::dump()
+{
+    LOCKER(m_entries.lock());
+    kprintf("ARP cache (%d entries):\n", m_entries.resource().size());
+    for (auto& it : m_entries.resource()) {
+        auto& entry = it.value;
+        if (entry.is_resolved)
+            kprintf("%s :: %s\n", entry.mac_address.to_string().characters(), it.key.to_string().characters());
+        else
+            kprintf("(incomplete) :: %s, %d packet(s) pending\n", it.key.to_string().characters(), entry.pending_packets.size());
+    }
+}
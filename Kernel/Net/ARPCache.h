@@ -0,0 +1,46 @@
+#pragma once
+
+#include <AK/ByteBuffer.h>
+#include <AK/HashMap.h>
+#include <AK/Vector.h>
+#include <Kernel/Lock.h>
+#include <Kernel/Net/IPv4.h>
+#include <Kernel/Net/MACAddress.h>
+
+class NetworkAdapter;
+
+class ARPCache {
+public:
+    static ARPCache& the();
+
+    bool lookup(const IPv4Address&, MACAddress&);
+
+    // Remember a binding, and send off any packets that were waiting for it.
+    void update(const IPv4Address&, const MACAddress&);
+
+    // Hold on to an outgoing packet until 'next_hop' is resolved, sending an ARP request for it if needed.
+    void enqueue(NetworkAdapter&, const IPv4Address& next_hop, const IPv4Address& destination, IPv4Protocol, ByteBuffer&& payload, int payload_checksum_offset);
+
+    void dump();
+
+private:
+    ARPCache() { }
+
+    struct PendingPacket {
+        IPv4Address destination;
+        IPv4Protocol protocol;
+        ByteBuffer payload;
+        int payload_checksum_offset;
+    };
+
+    struct Entry {
+        MACAddress mac_address;
+        bool is_resolved { false };
+        // When a resolved entry goes stale, or when an unresolved entry's request should be retried.
+        dword expiration_time { 0 };
+        NetworkAdapter* adapter { nullptr };
+        Vector<PendingPacket> pending_packets;
+    };
+
+    Lockable<HashMap<IPv4Address, Entry>> m_entries;
+};
@@ -0,0 +1,100 @@
+#include <Kernel/Net/Checksum.h>
+
+static inline word fold(qword sum)
+{
+    sum = (sum & 0xffffffff) + (sum >> 32);
+    sum = (sum & 0xffffffff) + (sum >> 32);
+    sum = (sum & 0xffff) + (sum >> 16);
+    sum = (sum & 0xffff) + (sum >> 16);
+    return (word)sum;
+}
+
+static inline word swap_bytes(word w)
+{
+    return (word)((w >> 8) | (w << 8));
+}
+
+// NOTE: The kernel doesn't preserve SSE state across context switches,
+//       so we stick to general purpose registers here. On i686, each 64-bit add
+//       becomes an add/adc pair, which gives us the classic add-with-carry loop.
+template<bool copy>
+static qword sum_and_maybe_copy(byte* dest, const byte* src, size_t count)
+{
+    qword sum = 0;
+    auto* s = (const dword*)src;
+    auto* d = (dword*)dest;
+    while (count >= 32) {
+        dword a = s[0], b = s[1], c = s[2], e = s[3], f = s[4], g = s[5], h = s[6], i = s[7];
+        if (copy) {
+            d[0] = a; d[1] = b; d[2] = c; d[3] = e;
+            d[4] = f; d[5] = g; d[6] = h; d[7] = i;
+            d += 8;
+        }
+        sum += a;
+        sum += b;
+        sum += c;
+        sum += e;
+        sum += f;
+        sum += g;
+        sum += h;
+        sum += i;
+        s += 8;
+        count -= 32;
+    }
+    while (count >= 4) {
+        dword a = *(s++);
+        if (copy)
+            *(d++) = a;
+        sum += a;
+        count -= 4;
+    }
+    auto* sb = (const byte*)s;
+    auto* db = (byte*)d;
+    if (count >= 2) {
+        word a = *(const word*)sb;
+        if (copy)
+            *(word*)db = a;
+        sum += a;
+        sb += 2;
+        db += 2;
+        count -= 2;
+    }
+    if (count) {
+        // A trailing odd byte is padded with a zero byte. In memory order, that's just the byte.
+        if (copy)
+            *db = *sb;
+        sum += *sb;
+    }
+    return sum;
+}
+
+void InternetChecksum::add_chunk_sum(qword chunk_sum)
+{
+    // Data that starts at an odd offset has its bytes swapped relative to the rest (RFC 1071, 2.B)
+    if (m_odd)
+        chunk_sum = swap_bytes(fold(chunk_sum));
+    m_sum += chunk_sum;
+}
+
+void InternetChecksum::add(const void* data, size_t count)
+{
+    if (!count)
+        return;
+    add_chunk_sum(sum_and_maybe_copy<false>(nullptr, (const byte*)data, count));
+    if (count & 1)
+        m_odd = !m_odd;
+}
+
+void InternetChecksum::add_and_copy(void* dest, const void* src, size_t count)
+{
+    if (!count)
+        return;
+    add_chunk_sum(sum_and_maybe_copy<true>((byte*)dest, (const byte*)src, count));
+    if (count & 1)
+        m_odd = !m_odd;
+}
+
+word InternetChecksum::partial() const
+{
+    return swap_bytes(fold(m_sum));
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <AK/NetworkOrdered.h>
+#include <AK/Types.h>
+
+// RFC 1071 internet checksum, accumulated 32 bits at a time into a 64-bit sum.
+// The one's complement sum is byte order independent, so we sum the data in
+// memory order and only swap once when producing the final result.
+class InternetChecksum {
+public:
+    InternetChecksum() { }
+
+    void add(const void*, size_t);
+
+    // Copy 'count' bytes from 'src' to 'dest' and checksum them in the same pass.
+    void add_and_copy(void* dest, const void* src, size_t count);
+
+    // The folded (but not inverted) sum, as seeded into a checksum field for hardware offload.
+    word partial() const;
+
+    NetworkOrdered<word> finish() const { return (word)~partial(); }
+
+private:
+    void add_chunk_sum(qword);
+
+    qword m_sum { 0 };
+    bool m_odd { false };
+};
+
+inline NetworkOrdered<word> internet_checksum(const void* ptr, size_t count)
+{
+    InternetChecksum checksum;
+    checksum.add(ptr, count);
+    return checksum.finish();
+}
+
+// RFC 1624 incremental update: HC' = ~(~HC + ~m + m')
+// Returns the new checksum after a 16-bit field in the checksummed data changes from 'old_value' to 'new_value'.
+inline word internet_checksum_update(word checksum, word old_value, word new_value)
+{
+    dword sum = (word)~checksum + (word)~old_value + new_value;
+    sum = (sum & 0xffff) + (sum >> 16);
+    sum = (sum & 0xffff) + (sum >> 16);
+    return ~sum & 0xffff;
+}
@@ -24,6 +24,7 @@
 #define REG_RADV        0x282C // RX Int. Absolute Delay Timer
 #define REG_RSRPD       0x2C00 // RX Small Packet Detect Interrupt
 #define REG_TIPG        0x0410 // Transmit Inter Packet Gap
+#define REG_RXCSUM      0x5000 // RX Checksum Control
 #define ECTRL_SLU        0x40        //set link up
 #define RCTL_EN                         (1 << 1)    // Receiver Enable
 #define RCTL_SBP                        (1 << 2)    // Store Bad Packets
@@ -47,6 +48,18 @@
 #define RCTL_PMCF                       (1 << 23)   // Pass MAC Control Frames
 #define RCTL_SECRC                      (1 << 26)   // Strip Ethernet CRC
 
+// RXCSUM Register
+
+#define RXCSUM_IPOFLD                   (1 << 8)    // IP Checksum Offload Enable
+#define RXCSUM_TUOFLD                   (1 << 9)    // TCP/UDP Checksum Offload Enable
+
+// Receive Descriptor Status / Errors
+
+#define RSTA_DD                         (1 << 0)    // Descriptor Done
+#define RSTA_IXSM                       (1 << 2)    // Ignore Checksum Indication
+#define RERR_TCPE                       (1 << 5)    // TCP/UDP Checksum Error
+#define RERR_IPE                        (1 << 6)    // IP Checksum Error
+
 // Buffer Sizes
 #define RCTL_BSIZE_256                  (3 << 16)
 #define RCTL_BSIZE_512                  (2 << 16)
@@ -231,6 +244,7 @@ void E1000NetworkAdapter::initialize_rx_descriptors()
     out32(REG_RXDESCHEAD, 0);
     out32(REG_RXDESCTAIL, number_of_rx_descriptors - 1);
 
+    out32(REG_RXCSUM, RXCSUM_IPOFLD | RXCSUM_TUOFLD);
     out32(REG_RCTRL, RCTL_EN| RCTL_SBP| RCTL_UPE | RCTL_MPE | RCTL_LBM_NONE | RTCL_RDMTS_HALF | RCTL_BAM | RCTL_SECRC  | RCTL_BSIZE_8192);
 }
 
@@ -309,6 +323,18 @@ dword E1000NetworkAdapter::in32(word address)
 }
 
 void E1000NetworkAdapter::send_raw(const byte* data, int length)
+{
+    transmit(data, length, 0, 0, 0);
+}
+
+void E1000NetworkAdapter::send_raw_with_checksum_offload(const byte* data, int length, int checksum_start, int checksum_offset)
+{
+    // Legacy descriptors can insert one checksum, computed from CSS to the end of the packet.
+    ASSERT(checksum_start < 256 && checksum_offset < 256);
+    transmit(data, length, CMD_IC, checksum_start, checksum_offset);
+}
+
+void E1000NetworkAdapter::transmit(const byte* data, int length, byte extra_command, byte checksum_start, byte checksum_offset)
 {
     dword tx_current = in32(REG_TXDESCTAIL);
 #ifdef E1000_DEBUG
@@ -319,7 +345,9 @@ void E1000NetworkAdapter::send_raw(const byte* data, int length)
     memcpy((void*)descriptor.addr, data, length);
     descriptor.length = length;
     descriptor.status = 0;
-    descriptor.cmd = CMD_EOP | CMD_IFCS | CMD_RS;
+    descriptor.css = checksum_start;
+    descriptor.cso = checksum_offset;
+    descriptor.cmd = CMD_EOP | CMD_IFCS | CMD_RS | extra_command;
 #ifdef E1000_DEBUG
     kprintf("E1000: Using tx descriptor %d (head is at %d)\n", tx_current, in32(REG_TXDESCHEAD));
 #endif
@@ -340,15 +368,24 @@ void E1000NetworkAdapter::receive()
         if (rx_current == in32(REG_RXDESCHEAD))
             return;
         rx_current = (rx_current + 1) % number_of_rx_descriptors;
-        if (!(m_rx_descriptors[rx_current].status & 1))
+        auto& descriptor = m_rx_descriptors[rx_current];
+        if (!(descriptor.status & RSTA_DD))
             break;
-        auto* buffer = (byte*)m_rx_descriptors[rx_current].addr;
-        word length = m_rx_descriptors[rx_current].length;
+        auto* buffer = (byte*)descriptor.addr;
+        word length = descriptor.length;
 #ifdef E1000_DEBUG
         kprintf("E1000: Received 1 packet @ %p (%u) bytes!\n", buffer, length);
 #endif
-        did_receive(buffer, length);
-        m_rx_descriptors[rx_current].status = 0;
+        // The NIC verifies IP and TCP/UDP checksums on receive, so we can drop anything it flagged right here.
+        if (!(descriptor.status & RSTA_IXSM) && (descriptor.errors & (RERR_IPE | RERR_TCPE))) {
+#ifdef E1000_DEBUG
+            kprintf("E1000: Dropping packet with bad checksum (errors=%b)\n", descriptor.errors);
+#endif
+            did_drop_packet();
+        } else {
+            did_receive(buffer, length);
+        }
+        descriptor.status = 0;
         out32(REG_RXDESCTAIL, rx_current);
     }
 }
@@ -16,6 +16,8 @@ public:
     virtual ~E1000NetworkAdapter() override;
 
     virtual void send_raw(const byte*, int) override;
+    virtual void send_raw_with_checksum_offload(const byte*, int, int checksum_start, int checksum_offset) override;
+    virtual bool has_checksum_offload() const override { return true; }
 
 private:
     virtual void handle_irq() override;
@@ -58,6 +60,7 @@ private:
     dword in32(word address);
 
     void receive();
+    void transmit(const byte*, int, byte extra_command, byte checksum_start, byte checksum_offset);
 
     PCI::Address m_pci_address;
     word m_io_base { 0 };
@@ -4,6 +4,7 @@
 #include <AK/Assertions.h>
 #include <AK/NetworkOrdered.h>
 #include <AK/Types.h>
+#include <Kernel/Net/Checksum.h>
 
 enum class IPv4Protocol : word {
     ICMP = 1,
@@ -11,11 +12,9 @@ enum class IPv4Protocol : word {
     UDP = 17,
 };
 
-NetworkOrdered<word> internet_checksum(const void*, size_t);
-
 class [[gnu::packed]] IPv4Address {
 public:
-    IPv4Address() { }
+    IPv4Address() { m_data_as_dword = 0; }
     IPv4Address(const byte data[4])
     {
         m_data[0] = data[0];
@@ -42,6 +41,9 @@ public:
         return String::format("%u.%u.%u.%u", m_data[0], m_data[1], m_data[2], m_data[3]);
     }
 
+    // NOTE: This is in network order, which is fine for masking and comparisons.
+    dword as_dword() const { return m_data_as_dword; }
+
     bool operator==(const IPv4Address& other) const { return m_data_as_dword == other.m_data_as_dword; }
     bool operator!=(const IPv4Address& other) const { return m_data_as_dword != other.m_data_as_dword; }
 
@@ -118,18 +120,3 @@ private:
 };
 
 static_assert(sizeof(IPv4Packet) == 20);
-
-inline NetworkOrdered<word> internet_checksum(const void* ptr, size_t count)
-{
-    dword checksum = 0;
-    auto* w = (const word*)ptr;
-    while (count > 1) {
-        checksum += convert_between_host_and_network(*w++);
-        if (checksum & 0x80000000)
-            checksum = (checksum & 0xffff) | (checksum >> 16);
-        count -= 2;
-    }
-    while (checksum >> 16)
-        checksum = (checksum & 0xffff) + (checksum >> 16);
-    return ~checksum & 0xffff;
-}
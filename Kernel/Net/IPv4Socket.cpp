@@ -12,7 +12,7 @@
 #include <Kernel/Net/Routing.h>
 #include <LibC/errno_numbers.h>
 
-#define IPV4_SOCKET_DEBUG
+//#define IPV4_SOCKET_DEBUG
 
 Lockable<HashTable<IPv4Socket*>>& IPv4Socket::all_sockets()
 {
@@ -22,6 +22,14 @@ Lockable<HashTable<IPv4Socket*>>& IPv4Socket::all_sockets()
     return *s_table;
 }
 
+Lockable<HashTable<IPv4Socket*>>& IPv4Socket::raw_sockets()
+{
+    static Lockable<HashTable<IPv4Socket*>>* s_table;
+    if (!s_table)
+        s_table = new Lockable<HashTable<IPv4Socket*>>;
+    return *s_table;
+}
+
 Retained<IPv4Socket> IPv4Socket::create(int type, int protocol)
 {
     if (type == SOCK_STREAM)
@@ -35,14 +43,26 @@ IPv4Socket::IPv4Socket(int type, int protocol)
     : Socket(AF_INET, type, protocol)
 {
     kprintf("%s(%u) IPv4Socket{%p} created with type=%u, protocol=%d\n", current->process().name().characters(), current->pid(), this, type, protocol);
-    LOCKER(all_sockets().lock());
-    all_sockets().resource().set(this);
+    {
+        LOCKER(all_sockets().lock());
+        all_sockets().resource().set(this);
+    }
+    if (type == SOCK_RAW) {
+        LOCKER(raw_sockets().lock());
+        raw_sockets().resource().set(this);
+    }
 }
 
 IPv4Socket::~IPv4Socket()
 {
-    LOCKER(all_sockets().lock());
-    all_sockets().resource().remove(this);
+    {
+        LOCKER(all_sockets().lock());
+        all_sockets().resource().remove(this);
+    }
+    if (type() == SOCK_RAW) {
+        LOCKER(raw_sockets().lock());
+        raw_sockets().resource().remove(this);
+    }
 }
 
 bool IPv4Socket::get_address(sockaddr* address, socklen_t* address_size)
@@ -141,8 +161,8 @@ ssize_t IPv4Socket::sendto(const void* data, size_t data_length, int flags, cons
         m_destination_port = ntohs(ia.sin_port);
     }
 
-    auto* adapter = adapter_for_route_to(m_destination_address);
-    if (!adapter)
+    auto routing_decision = route_to_destination();
+    if (!routing_decision.is_valid())
         return -EHOSTUNREACH;
 
     int rc = allocate_source_port_if_needed();
@@ -152,13 +172,24 @@ ssize_t IPv4Socket::sendto(const void* data, size_t data_length, int flags, cons
     kprintf("sendto: destination=%s:%u\n", m_destination_address.to_string().characters(), m_destination_port);
 
     if (type() == SOCK_RAW) {
-        adapter->send_ipv4(MACAddress(), m_destination_address, (IPv4Protocol)protocol(), ByteBuffer::copy(data, data_length));
+        routing_decision.adapter->send_ipv4_via(routing_decision.next_hop, m_destination_address, (IPv4Protocol)protocol(), ByteBuffer::copy(data, data_length));
         return data_length;
     }
 
     return protocol_send(data, data_length);
 }
 
+RoutingDecision IPv4Socket::route_to_destination()
+{
+    auto& routing_table = RoutingTable::the();
+    if (m_route_generation != routing_table.generation() || m_route_destination != m_destination_address) {
+        m_route = routing_table.route_to(m_destination_address);
+        m_route_destination = m_destination_address;
+        m_route_generation = routing_table.generation();
+    }
+    return m_route;
+}
+
 ssize_t IPv4Socket::recvfrom(void* buffer, size_t buffer_length, int flags, sockaddr* addr, socklen_t* addr_length)
 {
     (void)flags;
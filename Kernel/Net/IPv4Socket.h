@@ -3,6 +3,7 @@
 #include <Kernel/Socket.h>
 #include <Kernel/DoubleBuffer.h>
 #include <Kernel/Net/IPv4.h>
+#include <Kernel/Net/Routing.h>
 #include <AK/HashMap.h>
 #include <Kernel/Lock.h>
 #include <AK/SinglyLinkedList.h>
@@ -19,6 +20,7 @@ public:
     virtual ~IPv4Socket() override;
 
     static Lockable<HashTable<IPv4Socket*>>& all_sockets();
+    static Lockable<HashTable<IPv4Socket*>>& raw_sockets();
 
     virtual KResult bind(const sockaddr*, socklen_t) override;
     virtual KResult connect(const sockaddr*, socklen_t) override;
@@ -47,6 +49,9 @@ protected:
 
     int allocate_source_port_if_needed();
 
+    // Reuses the last routing decision until the destination or the routing table changes.
+    RoutingDecision route_to_destination();
+
     virtual int protocol_receive(const ByteBuffer&, void*, size_t, int, sockaddr*, socklen_t*) { return -ENOTIMPL; }
     virtual int protocol_send(const void*, int) { return -ENOTIMPL; }
     virtual KResult protocol_connect() { return KSuccess; }
@@ -60,6 +65,10 @@ private:
     int m_attached_fds { 0 };
     IPv4Address m_destination_address;
 
+    RoutingDecision m_route;
+    IPv4Address m_route_destination;
+    dword m_route_generation { 0 };
+
     DoubleBuffer m_for_client;
     DoubleBuffer m_for_server;
 
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <AK/HashFunctions.h>
+#include <AK/RetainPtr.h>
+#include <AK/Vector.h>
+#include <Kernel/Lock.h>
+#include <Kernel/Net/IPv4.h>
+
+struct IPv4SocketTuple {
+    IPv4Address local_address;
+    word local_port { 0 };
+    IPv4Address peer_address;
+    word peer_port { 0 };
+
+    // Matches anything sent to 'local_port' that isn't claimed by a connected socket.
+    static IPv4SocketTuple wildcard(word local_port)
+    {
+        IPv4SocketTuple tuple;
+        tuple.local_port = local_port;
+        return tuple;
+    }
+
+    bool operator==(const IPv4SocketTuple& other) const
+    {
+        return local_port == other.local_port
+            && peer_port == other.peer_port
+            && local_address == other.local_address
+            && peer_address == other.peer_address;
+    }
+
+    unsigned hash() const
+    {
+        return pair_int_hash(pair_int_hash(local_address.as_dword(), peer_address.as_dword()), (local_port << 16) | peer_port);
+    }
+};
+
+// Demultiplexes incoming packets to sockets. Every bucket has its own lock,
+// so lookups for unrelated connections don't contend with each other.
+template<typename T>
+class IPv4SocketTable {
+public:
+    IPv4SocketTable() { }
+
+    // Returns false if the tuple is already taken.
+    bool add(const IPv4SocketTuple& tuple, T& socket)
+    {
+        auto& bucket = bucket_for(tuple);
+        LOCKER(bucket.lock);
+        for (auto& entry : bucket.entries) {
+            if (entry.tuple == tuple)
+                return false;
+        }
+        bucket.entries.append({ tuple, &socket });
+        return true;
+    }
+
+    void remove(const IPv4SocketTuple& tuple, T& socket)
+    {
+        auto& bucket = bucket_for(tuple);
+        LOCKER(bucket.lock);
+        bucket.entries.remove_first_matching([&] (auto& entry) {
+            return entry.socket == &socket && entry.tuple == tuple;
+        });
+    }
+
+    bool contains(const IPv4SocketTuple& tuple)
+    {
+        return find(tuple);
+    }
+
+    // Prefers a socket connected to the peer, and falls back to one bound to the local port.
+    RetainPtr<T> lookup(const IPv4SocketTuple& tuple)
+    {
+        if (auto socket = find(tuple))
+            return socket;
+        return find(IPv4SocketTuple::wildcard(tuple.local_port));
+    }
+
+private:
+    struct Entry {
+        IPv4SocketTuple tuple;
+        T* socket { nullptr };
+    };
+
+    struct Bucket {
+        Lock lock;
+        Vector<Entry> entries;
+    };
+
+    static const int bucket_count = 64;
+
+    Bucket& bucket_for(const IPv4SocketTuple& tuple) { return m_buckets[tuple.hash() % bucket_count]; }
+
+    RetainPtr<T> find(const IPv4SocketTuple& tuple)
+    {
+        auto& bucket = bucket_for(tuple);
+        LOCKER(bucket.lock);
+        for (auto& entry : bucket.entries) {
+            if (entry.tuple == tuple)
+                return entry.socket;
+        }
+        return nullptr;
+    }
+
+    Bucket m_buckets[bucket_count];
+};
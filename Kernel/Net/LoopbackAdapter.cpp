@@ -1,5 +1,7 @@
 #include <Kernel/Net/LoopbackAdapter.h>
 
+//#define LOOPBACK_DEBUG
+
 LoopbackAdapter& LoopbackAdapter::the()
 {
     static LoopbackAdapter* the;
@@ -19,6 +21,8 @@ LoopbackAdapter::~LoopbackAdapter()
 
 void LoopbackAdapter::send_raw(const byte* data, int size)
 {
+#ifdef LOOPBACK_DEBUG
     dbgprintf("LoopbackAdapter: Sending %d byte(s) to myself.\n", size);
+#endif
     did_receive(data, size);
 }
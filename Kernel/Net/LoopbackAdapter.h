@@ -11,6 +11,7 @@ public:
 
     virtual void send_raw(const byte*, int) override;
     virtual const char* class_name() const override { return "LoopbackAdapter"; }
+    virtual bool requires_address_resolution() const override { return false; }
 
 private:
     LoopbackAdapter();
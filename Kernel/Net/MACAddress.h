@@ -7,7 +7,7 @@
 
 class [[gnu::packed]] MACAddress {
 public:
-    MACAddress() { }
+    MACAddress() { memset(m_data, 0, sizeof(m_data)); }
     MACAddress(const byte data[6])
     {
         memcpy(m_data, data, 6);
@@ -25,6 +25,12 @@ public:
         return !memcmp(m_data, other.m_data, sizeof(m_data));
     }
 
+    static MACAddress broadcast()
+    {
+        const byte data[6] { 0xff, 0xff, 0xff, 0xff, 0xff, 0xff };
+        return MACAddress(data);
+    }
+
     String to_string() const
     {
         return String::format("%b:%b:%b:%b:%b:%b", m_data[0], m_data[1], m_data[2], m_data[3], m_data[4], m_data[5]);
@@ -1,6 +1,9 @@
 #include <Kernel/Net/NetworkAdapter.h>
+#include <Kernel/Net/ARPCache.h>
+#include <Kernel/Net/Routing.h>
 #include <Kernel/Net/EthernetFrameHeader.h>
 #include <Kernel/Net/EtherType.h>
+#include <Kernel/Net/NetworkStatistics.h>
 #include <Kernel/StdLib.h>
 #include <Kernel/kmalloc.h>
 #include <AK/HashTable.h>
@@ -24,6 +27,13 @@ NetworkAdapter* NetworkAdapter::from_ipv4_address(const IPv4Address& address)
     return nullptr;
 }
 
+void NetworkAdapter::for_each(Function<void(NetworkAdapter&)> callback)
+{
+    LOCKER(all_adapters().lock());
+    for (auto* adapter : all_adapters().resource())
+        callback(*adapter);
+}
+
 NetworkAdapter::NetworkAdapter()
     : m_packet_queue_alarm(*this)
 {
@@ -35,6 +45,7 @@ NetworkAdapter::~NetworkAdapter()
 {
     // FIXME: I wanna lock :(
     all_adapters().resource().remove(this);
+    RoutingTable::the().remove_routes_for(*this);
 }
 
 void NetworkAdapter::send(const MACAddress& destination, const ARPPacket& packet)
@@ -46,10 +57,13 @@ void NetworkAdapter::send(const MACAddress& destination, const ARPPacket& packet
     eth->set_destination(destination);
     eth->set_ether_type(EtherType::ARP);
     memcpy(eth->payload(), &packet, sizeof(ARPPacket));
+    ++NetworkStatistics::the().arp.packets_sent;
+    ++m_packets_out;
+    m_bytes_out += size_in_bytes;
     send_raw((byte*)eth, size_in_bytes);
 }
 
-void NetworkAdapter::send_ipv4(const MACAddress& destination_mac, const IPv4Address& destination_ipv4, IPv4Protocol protocol, ByteBuffer&& payload)
+void NetworkAdapter::send_ipv4(const MACAddress& destination_mac, const IPv4Address& destination_ipv4, IPv4Protocol protocol, ByteBuffer&& payload, int payload_checksum_offset)
 {
     size_t size_in_bytes = sizeof(EthernetFrameHeader) + sizeof(IPv4Packet) + payload.size();
     auto buffer = ByteBuffer::create_zeroed(size_in_bytes);
@@ -68,21 +82,65 @@ void NetworkAdapter::send_ipv4(const MACAddress& destination_mac, const IPv4Addr
     ipv4.set_ttl(64);
     ipv4.set_checksum(ipv4.compute_checksum());
     memcpy(ipv4.payload(), payload.pointer(), payload.size());
+    auto& statistics = NetworkStatistics::the();
+    ++statistics.ipv4.packets_sent;
+    if (auto* protocol_statistics = statistics.for_protocol(protocol))
+        ++protocol_statistics->packets_sent;
+    ++m_packets_out;
+    m_bytes_out += size_in_bytes;
+    if (payload_checksum_offset >= 0) {
+        ASSERT(has_checksum_offload());
+        int checksum_start = sizeof(EthernetFrameHeader) + sizeof(IPv4Packet);
+        send_raw_with_checksum_offload((const byte*)&eth, size_in_bytes, checksum_start, checksum_start + payload_checksum_offset);
+        return;
+    }
     send_raw((const byte*)&eth, size_in_bytes);
 }
 
+void NetworkAdapter::send_ipv4_via(const IPv4Address& next_hop, const IPv4Address& destination_ipv4, IPv4Protocol protocol, ByteBuffer&& payload, int payload_checksum_offset)
+{
+    if (!requires_address_resolution()) {
+        send_ipv4(MACAddress(), destination_ipv4, protocol, move(payload), payload_checksum_offset);
+        return;
+    }
+    MACAddress destination_mac;
+    if (ARPCache::the().lookup(next_hop, destination_mac)) {
+        send_ipv4(destination_mac, destination_ipv4, protocol, move(payload), payload_checksum_offset);
+        return;
+    }
+    ARPCache::the().enqueue(*this, next_hop, destination_ipv4, protocol, move(payload), payload_checksum_offset);
+}
+
+void NetworkAdapter::send_arp_request(const IPv4Address& address)
+{
+    ARPPacket request;
+    request.set_operation(ARPOperation::Request);
+    request.set_sender_hardware_address(mac_address());
+    request.set_sender_protocol_address(ipv4_address());
+    request.set_target_protocol_address(address);
+    send(MACAddress::broadcast(), request);
+}
+
+void NetworkAdapter::send_raw_with_checksum_offload(const byte*, int, int, int)
+{
+    ASSERT_NOT_REACHED();
+}
+
 void NetworkAdapter::did_receive(const byte* data, int length)
 {
     InterruptDisabler disabler;
+    ++m_packets_in;
+    m_bytes_in += length;
     m_packet_queue.append(ByteBuffer::copy(data, length));
 }
 
-ByteBuffer NetworkAdapter::dequeue_packet()
+int NetworkAdapter::dequeue_packets(Vector<ByteBuffer>& packets, int max_count)
 {
     InterruptDisabler disabler;
-    if (m_packet_queue.is_empty())
-        return { };
-    return m_packet_queue.take_first();
+    int count = 0;
+    for (; count < max_count && !m_packet_queue.is_empty(); ++count)
+        packets.append(m_packet_queue.take_first());
+    return count;
 }
 
 void NetworkAdapter::set_ipv4_address(const IPv4Address& address)
@@ -1,8 +1,10 @@
 #pragma once
 
 #include <AK/ByteBuffer.h>
+#include <AK/Function.h>
 #include <AK/SinglyLinkedList.h>
 #include <AK/Types.h>
+#include <AK/Vector.h>
 #include <Kernel/Net/MACAddress.h>
 #include <Kernel/Net/IPv4.h>
 #include <Kernel/Net/ARP.h>
@@ -23,6 +25,7 @@ private:
 class NetworkAdapter {
 public:
     static NetworkAdapter* from_ipv4_address(const IPv4Address&);
+    static void for_each(Function<void(NetworkAdapter&)>);
     virtual ~NetworkAdapter();
 
     virtual const char* class_name() const = 0;
@@ -32,23 +35,48 @@ public:
     void set_ipv4_address(const IPv4Address&);
 
     void send(const MACAddress&, const ARPPacket&);
-    void send_ipv4(const MACAddress&, const IPv4Address&, IPv4Protocol, ByteBuffer&& payload);
+    // If 'payload_checksum_offset' is non-negative, the adapter must support checksum offload, and will
+    // finish the checksum at that offset, which should be seeded with the pseudo-header's partial sum.
+    void send_ipv4(const MACAddress&, const IPv4Address&, IPv4Protocol, ByteBuffer&& payload, int payload_checksum_offset = -1);
 
-    ByteBuffer dequeue_packet();
+    // Like send_ipv4(), but addressed to 'next_hop' on this adapter's link. If we don't know its MAC address yet,
+    // the packet is held in the ARP cache until we do.
+    void send_ipv4_via(const IPv4Address& next_hop, const IPv4Address&, IPv4Protocol, ByteBuffer&& payload, int payload_checksum_offset = -1);
+    void send_arp_request(const IPv4Address&);
+
+    virtual bool requires_address_resolution() const { return true; }
+
+    virtual bool has_checksum_offload() const { return false; }
+
+    // Moves up to 'max_count' received packets into 'packets', and returns how many there were.
+    int dequeue_packets(Vector<ByteBuffer>& packets, int max_count);
 
     Alarm& packet_queue_alarm() { return m_packet_queue_alarm; }
 
     bool has_queued_packets() const { return !m_packet_queue.is_empty(); }
 
+    dword packets_in() const { return m_packets_in; }
+    dword bytes_in() const { return m_bytes_in; }
+    dword packets_out() const { return m_packets_out; }
+    dword bytes_out() const { return m_bytes_out; }
+    dword packets_dropped() const { return m_packets_dropped; }
+
 protected:
     NetworkAdapter();
     void set_mac_address(const MACAddress& mac_address) { m_mac_address = mac_address; }
     virtual void send_raw(const byte*, int) = 0;
+    virtual void send_raw_with_checksum_offload(const byte*, int, int checksum_start, int checksum_offset);
     void did_receive(const byte*, int);
+    void did_drop_packet() { ++m_packets_dropped; }
 
 private:
     MACAddress m_mac_address;
     IPv4Address m_ipv4_address;
     PacketQueueAlarm m_packet_queue_alarm;
     SinglyLinkedList<ByteBuffer> m_packet_queue;
+    dword m_packets_in { 0 };
+    dword m_bytes_in { 0 };
+    dword m_packets_out { 0 };
+    dword m_bytes_out { 0 };
+    dword m_packets_dropped { 0 };
 };
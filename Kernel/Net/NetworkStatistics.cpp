@@ -0,0 +1,23 @@
+#include <Kernel/Net/NetworkStatistics.h>
+
+NetworkStatistics& NetworkStatistics::the()
+{
+    static NetworkStatistics* the;
+    if (!the)
+        the = new NetworkStatistics;
+    return *the;
+}
+
+ProtocolStatistics* NetworkStatistics::for_protocol(IPv4Protocol protocol)
+{
+    switch (protocol) {
+    case IPv4Protocol::ICMP:
+        return &icmp;
+    case IPv4Protocol::UDP:
+        return &udp;
+    case IPv4Protocol::TCP:
+        return &tcp;
+    default:
+        return nullptr;
+    }
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <AK/Types.h>
+#include <Kernel/Net/IPv4.h>
+
+struct ProtocolStatistics {
+    dword packets_received { 0 };
+    dword packets_sent { 0 };
+    dword packets_dropped { 0 };
+};
+
+// Packet counters for the whole network stack, as shown in /proc/net/stats.
+// NOTE: These are only statistics, so they're bumped without taking any locks.
+class NetworkStatistics {
+public:
+    static NetworkStatistics& the();
+
+    ProtocolStatistics* for_protocol(IPv4Protocol);
+
+    ProtocolStatistics ethernet;
+    ProtocolStatistics arp;
+    ProtocolStatistics ipv4;
+    ProtocolStatistics icmp;
+    ProtocolStatistics udp;
+    ProtocolStatistics tcp;
+
+private:
+    NetworkStatistics() { }
+};
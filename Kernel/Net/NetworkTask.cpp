@@ -1,3 +1,4 @@
+#include <Kernel/Net/ARPCache.h>
 #include <Kernel/Net/E1000NetworkAdapter.h>
 #include <Kernel/Net/EthernetFrameHeader.h>
 #include <Kernel/Net/ARP.h>
@@ -9,110 +10,138 @@
 #include <Kernel/Net/TCPSocket.h>
 #include <Kernel/Net/UDPSocket.h>
 #include <Kernel/Net/LoopbackAdapter.h>
+#include <Kernel/Net/Routing.h>
+#include <Kernel/Net/NetworkStatistics.h>
 #include <Kernel/Process.h>
 #include <Kernel/Net/EtherType.h>
 #include <Kernel/Lock.h>
 
 
 //#define ETHERNET_DEBUG
-#define IPV4_DEBUG
+//#define IPV4_DEBUG
 //#define ICMP_DEBUG
-#define UDP_DEBUG
-#define TCP_DEBUG
+//#define UDP_DEBUG
+//#define TCP_DEBUG
 
+// How many packets a worker handles per wake-up before checking its queue again.
+static const int max_packets_per_batch = 32;
+
+static void handle_packet(const ByteBuffer&);
 static void handle_arp(const EthernetFrameHeader&, int frame_size);
 static void handle_ipv4(const EthernetFrameHeader&, int frame_size);
 static void handle_icmp(const EthernetFrameHeader&, int frame_size);
 static void handle_udp(const EthernetFrameHeader&, int frame_size);
 static void handle_tcp(const EthernetFrameHeader&, int frame_size);
 
-Lockable<HashMap<IPv4Address, MACAddress>>& arp_table()
+static void configure_adapters(Vector<NetworkAdapter*>& adapters)
+{
+    auto& routing_table = RoutingTable::the();
+
+    auto& loopback = LoopbackAdapter::the();
+    routing_table.add_route({ 127, 0, 0, 0 }, { 255, 0, 0, 0 }, { }, loopback);
+    adapters.append(&loopback);
+
+    // FIXME: Get this configuration from userspace instead of hard-coding it.
+    if (auto* e1000 = E1000NetworkAdapter::the()) {
+        e1000->set_ipv4_address({ 192, 168, 5, 2 });
+        routing_table.add_route({ 192, 168, 5, 0 }, { 255, 255, 255, 0 }, { }, *e1000);
+        routing_table.add_route({ 0, 0, 0, 0 }, { 0, 0, 0, 0 }, { 192, 168, 5, 1 }, *e1000);
+        adapters.append(e1000);
+    }
+}
+
+static void run_worker(NetworkAdapter& adapter)
 {
-    static Lockable<HashMap<IPv4Address, MACAddress>>* the;
-    if (!the)
-        the = new Lockable<HashMap<IPv4Address, MACAddress>>;
-    return *the;
+    Vector<ByteBuffer> packets;
+    for (;;) {
+        packets.clear_with_capacity();
+        if (!adapter.dequeue_packets(packets, max_packets_per_batch)) {
+            current->snooze_until(adapter.packet_queue_alarm());
+            continue;
+        }
+        for (auto& packet : packets)
+            handle_packet(packet);
+    }
 }
 
-class CombinedPacketQueueAlarm : public Alarm {
-public:
-    CombinedPacketQueueAlarm() { }
+// NOTE: Adapters are all detected before we get here, and live forever,
+//       so the workers can share this list without taking any locks.
+static Vector<NetworkAdapter*>* s_adapters;
+static int s_next_unclaimed_adapter_index;
 
-    virtual bool is_ringing() const override
+static void NetworkTask_worker_main()
+{
+    NetworkAdapter* adapter;
     {
-        if (LoopbackAdapter::the().has_queued_packets())
-            return true;
-        if (auto* e1000 = E1000NetworkAdapter::the()) {
-            if (e1000->has_queued_packets())
-                return true;
-        }
-        return false;
+        InterruptDisabler disabler;
+        adapter = (*s_adapters)[s_next_unclaimed_adapter_index++];
     }
-};
+    kprintf("NetworkTask: Worker for %s entering main loop.\n", adapter->class_name());
+    run_worker(*adapter);
+}
 
 void NetworkTask_main()
 {
-    LoopbackAdapter::the();
-
-    auto* adapter_ptr = E1000NetworkAdapter::the();
-    ASSERT(adapter_ptr);
-    auto& adapter = *adapter_ptr;
-    adapter.set_ipv4_address(IPv4Address(192, 168, 5, 2));
-
-    auto dequeue_packet = [&] () -> ByteBuffer {
-        auto packet = LoopbackAdapter::the().dequeue_packet();
-        if (!packet.is_null()) {
-            dbgprintf("Receive loopback packet (%d bytes)\n", packet.size());
-            return packet;
-        }
-        if (adapter.has_queued_packets())
-            return adapter.dequeue_packet();
-        return { };
-    };
+    s_adapters = new Vector<NetworkAdapter*>;
+    configure_adapters(*s_adapters);
 
-    CombinedPacketQueueAlarm queue_alarm;
+    // Every adapter gets a worker of its own, so a busy one can't hold up the others.
+    // This thread takes care of the first one.
+    s_next_unclaimed_adapter_index = 1;
+    for (int i = 1; i < s_adapters->size(); ++i)
+        Process::create_kernel_process(String::format("NetworkTask:%s", (*s_adapters)[i]->class_name()), NetworkTask_worker_main);
 
     kprintf("NetworkTask: Enter main loop.\n");
-    for (;;) {
-        auto packet = dequeue_packet();
-        if (packet.is_null()) {
-            current->snooze_until(queue_alarm);
-            continue;
-        }
-        if (packet.size() < (int)(sizeof(EthernetFrameHeader))) {
-            kprintf("NetworkTask: Packet is too small to be an Ethernet packet! (%d)\n", packet.size());
-            continue;
-        }
-        auto& eth = *(const EthernetFrameHeader*)packet.pointer();
+    run_worker(*(*s_adapters)[0]);
+}
+
+void handle_packet(const ByteBuffer& packet)
+{
+    auto& statistics = NetworkStatistics::the();
+    ++statistics.ethernet.packets_received;
+    if (packet.size() < (int)(sizeof(EthernetFrameHeader))) {
+        ++statistics.ethernet.packets_dropped;
 #ifdef ETHERNET_DEBUG
-        kprintf("NetworkTask: From %s to %s, ether_type=%w, packet_length=%u\n",
-            eth.source().to_string().characters(),
-            eth.destination().to_string().characters(),
-            eth.ether_type(),
-            packet.size()
-        );
+        kprintf("NetworkTask: Packet is too small to be an Ethernet packet! (%d)\n", packet.size());
+#endif
+        return;
+    }
+    auto& eth = *(const EthernetFrameHeader*)packet.pointer();
+#ifdef ETHERNET_DEBUG
+    kprintf("NetworkTask: From %s to %s, ether_type=%w, packet_length=%u\n",
+        eth.source().to_string().characters(),
+        eth.destination().to_string().characters(),
+        eth.ether_type(),
+        packet.size()
+    );
 #endif
 
-        switch (eth.ether_type()) {
-        case EtherType::ARP:
-            handle_arp(eth, packet.size());
-            break;
-        case EtherType::IPv4:
-            handle_ipv4(eth, packet.size());
-            break;
-        }
+    switch (eth.ether_type()) {
+    case EtherType::ARP:
+        handle_arp(eth, packet.size());
+        break;
+    case EtherType::IPv4:
+        handle_ipv4(eth, packet.size());
+        break;
+    default:
+        ++statistics.ethernet.packets_dropped;
+        break;
     }
 }
 
 void handle_arp(const EthernetFrameHeader& eth, int frame_size)
 {
+    auto& statistics = NetworkStatistics::the().arp;
+    ++statistics.packets_received;
     constexpr int minimum_arp_frame_size = sizeof(EthernetFrameHeader) + sizeof(ARPPacket);
     if (frame_size < minimum_arp_frame_size) {
+        ++statistics.packets_dropped;
         kprintf("handle_arp: Frame too small (%d, need %d)\n", frame_size, minimum_arp_frame_size);
         return;
     }
     auto& packet = *static_cast<const ARPPacket*>(eth.payload());
     if (packet.hardware_type() != 1 || packet.hardware_address_length() != sizeof(MACAddress)) {
+        ++statistics.packets_dropped;
         kprintf("handle_arp: Hardware type not ethernet (%w, len=%u)\n",
             packet.hardware_type(),
             packet.hardware_address_length()
@@ -120,6 +149,7 @@ void handle_arp(const EthernetFrameHeader& eth, int frame_size)
         return;
     }
     if (packet.protocol_type() != EtherType::IPv4 || packet.protocol_address_length() != sizeof(IPv4Address)) {
+        ++statistics.packets_dropped;
         kprintf("handle_arp: Protocol type not IPv4 (%w, len=%u)\n",
             packet.hardware_type(),
             packet.protocol_address_length()
@@ -141,8 +171,10 @@ void handle_arp(const EthernetFrameHeader& eth, int frame_size)
         // Who has this IP address?
         if (auto* adapter = NetworkAdapter::from_ipv4_address(packet.target_protocol_address())) {
             // We do!
+#ifdef ARP_DEBUG
             kprintf("handle_arp: Responding to ARP request for my IPv4 address (%s)\n",
                     adapter->ipv4_address().to_string().characters());
+#endif
             ARPPacket response;
             response.set_operation(ARPOperation::Response);
             response.set_target_hardware_address(packet.sender_hardware_address());
@@ -151,29 +183,33 @@ void handle_arp(const EthernetFrameHeader& eth, int frame_size)
             response.set_sender_protocol_address(adapter->ipv4_address());
 
             adapter->send(packet.sender_hardware_address(), response);
+
+            // They'll likely want to talk to us next, so we might as well remember who they are.
+            ARPCache::the().update(packet.sender_protocol_address(), packet.sender_hardware_address());
         }
         return;
     }
 
     if (packet.operation() == ARPOperation::Response) {
         // Someone has this IPv4 address. I guess we can try to remember that.
-        // FIXME: Protect against ARP spamming.
         // FIXME: Support static ARP table entries.
-        LOCKER(arp_table().lock());
-        arp_table().resource().set(packet.sender_protocol_address(), packet.sender_hardware_address());
-
-        kprintf("ARP table (%d entries):\n", arp_table().resource().size());
-        for (auto& it : arp_table().resource()) {
-            kprintf("%s :: %s\n", it.value.to_string().characters(), it.key.to_string().characters());
-        }
+        ARPCache::the().update(packet.sender_protocol_address(), packet.sender_hardware_address());
+#ifdef ARP_DEBUG
+        ARPCache::the().dump();
+#endif
     }
 }
 
 void handle_ipv4(const EthernetFrameHeader& eth, int frame_size)
 {
+    auto& statistics = NetworkStatistics::the().ipv4;
+    ++statistics.packets_received;
     constexpr int minimum_ipv4_frame_size = sizeof(EthernetFrameHeader) + sizeof(IPv4Packet);
     if (frame_size < minimum_ipv4_frame_size) {
+        ++statistics.packets_dropped;
+#ifdef IPV4_DEBUG
         kprintf("handle_ipv4: Frame too small (%d, need %d)\n", frame_size, minimum_ipv4_frame_size);
+#endif
         return;
     }
     auto& packet = *static_cast<const IPv4Packet*>(eth.payload());
@@ -193,7 +229,10 @@ void handle_ipv4(const EthernetFrameHeader& eth, int frame_size)
     case IPv4Protocol::TCP:
         return handle_tcp(eth, frame_size);
     default:
+        ++statistics.packets_dropped;
+#ifdef IPV4_DEBUG
         kprintf("handle_ipv4: Unhandled protocol %u\n", packet.protocol());
+#endif
         break;
     }
 }
@@ -201,6 +240,7 @@ void handle_ipv4(const EthernetFrameHeader& eth, int frame_size)
 void handle_icmp(const EthernetFrameHeader& eth, int frame_size)
 {
     (void)frame_size;
+    ++NetworkStatistics::the().icmp.packets_received;
     auto& ipv4_packet = *static_cast<const IPv4Packet*>(eth.payload());
     auto& icmp_header = *static_cast<const ICMPHeader*>(ipv4_packet.payload());
 #ifdef ICMP_DEBUG
@@ -213,13 +253,17 @@ void handle_icmp(const EthernetFrameHeader& eth, int frame_size)
 #endif
 
     {
-        LOCKER(IPv4Socket::all_sockets().lock());
-        for (RetainPtr<IPv4Socket> socket : IPv4Socket::all_sockets().resource()) {
-            LOCKER(socket->lock());
-            if (socket->protocol() != (unsigned)IPv4Protocol::ICMP)
-                continue;
-            socket->did_receive(ByteBuffer::copy(&ipv4_packet, sizeof(IPv4Packet) + ipv4_packet.payload_size()));
+        // Only raw sockets see ICMP traffic, so grab those and deliver without holding the table lock.
+        Vector<RetainPtr<IPv4Socket>> icmp_sockets;
+        {
+            LOCKER(IPv4Socket::raw_sockets().lock());
+            for (auto* socket : IPv4Socket::raw_sockets().resource()) {
+                if (socket->protocol() == (unsigned)IPv4Protocol::ICMP)
+                    icmp_sockets.append(socket);
+            }
         }
+        for (auto& socket : icmp_sockets)
+            socket->did_receive(ByteBuffer::copy(&ipv4_packet, sizeof(IPv4Packet) + ipv4_packet.payload_size()));
     }
 
     auto* adapter = NetworkAdapter::from_ipv4_address(ipv4_packet.destination());
@@ -228,21 +272,22 @@ void handle_icmp(const EthernetFrameHeader& eth, int frame_size)
 
     if (icmp_header.type() == ICMPType::EchoRequest) {
         auto& request = reinterpret_cast<const ICMPEchoPacket&>(icmp_header);
+#ifdef ICMP_DEBUG
         kprintf("handle_icmp: EchoRequest from %s: id=%u, seq=%u\n",
                 ipv4_packet.source().to_string().characters(),
                 (word)request.identifier,
                 (word)request.sequence_number
         );
+#endif
         size_t icmp_packet_size = ipv4_packet.payload_size();
-        auto buffer = ByteBuffer::create_zeroed(icmp_packet_size);
+        auto buffer = ByteBuffer::copy(&request, icmp_packet_size);
         auto& response = *(ICMPEchoPacket*)buffer.pointer();
         response.header.set_type(ICMPType::EchoReply);
         response.header.set_code(0);
-        response.identifier = request.identifier;
-        response.sequence_number = request.sequence_number;
-        if (size_t icmp_payload_size = icmp_packet_size - sizeof(ICMPEchoPacket))
-            memcpy(response.payload(), request.payload(), icmp_payload_size);
-        response.header.set_checksum(internet_checksum(&response, icmp_packet_size));
+        // Only the type and code differ from the request, so patch its checksum instead of summing the payload again.
+        word old_type_and_code = (request.header.type() << 8) | request.header.code();
+        word new_type_and_code = ICMPType::EchoReply << 8;
+        response.header.set_checksum(internet_checksum_update(request.header.checksum(), old_type_and_code, new_type_and_code));
         adapter->send_ipv4(eth.source(), ipv4_packet.source(), IPv4Protocol::ICMP, move(buffer));
     }
 }
@@ -250,11 +295,16 @@ void handle_icmp(const EthernetFrameHeader& eth, int frame_size)
 void handle_udp(const EthernetFrameHeader& eth, int frame_size)
 {
     (void)frame_size;
+    auto& statistics = NetworkStatistics::the().udp;
+    ++statistics.packets_received;
     auto& ipv4_packet = *static_cast<const IPv4Packet*>(eth.payload());
 
     auto* adapter = NetworkAdapter::from_ipv4_address(ipv4_packet.destination());
     if (!adapter) {
+        ++statistics.packets_dropped;
+#ifdef UDP_DEBUG
         kprintf("handle_udp: this packet is not for me, it's for %s\n", ipv4_packet.destination().to_string().characters());
+#endif
         return;
     }
 
@@ -269,9 +319,12 @@ void handle_udp(const EthernetFrameHeader& eth, int frame_size)
     );
 #endif
 
-    auto socket = UDPSocket::from_port(udp_packet.destination_port());
+    auto socket = UDPSocket::from_tuple({ ipv4_packet.destination(), udp_packet.destination_port(), ipv4_packet.source(), udp_packet.source_port() });
     if (!socket) {
+        ++statistics.packets_dropped;
+#ifdef UDP_DEBUG
         kprintf("handle_udp: No UDP socket for port %u\n", udp_packet.destination_port());
+#endif
         return;
     }
 
@@ -283,11 +336,16 @@ void handle_udp(const EthernetFrameHeader& eth, int frame_size)
 void handle_tcp(const EthernetFrameHeader& eth, int frame_size)
 {
     (void)frame_size;
+    auto& statistics = NetworkStatistics::the().tcp;
+    ++statistics.packets_received;
     auto& ipv4_packet = *static_cast<const IPv4Packet*>(eth.payload());
 
     auto* adapter = NetworkAdapter::from_ipv4_address(ipv4_packet.destination());
     if (!adapter) {
+        ++statistics.packets_dropped;
+#ifdef TCP_DEBUG
         kprintf("handle_tcp: this packet is not for me, it's for %s\n", ipv4_packet.destination().to_string().characters());
+#endif
         return;
     }
 
@@ -310,9 +368,12 @@ void handle_tcp(const EthernetFrameHeader& eth, int frame_size)
     );
 #endif
 
-    auto socket = TCPSocket::from_port(tcp_packet.destination_port());
+    auto socket = TCPSocket::from_tuple({ ipv4_packet.destination(), tcp_packet.destination_port(), ipv4_packet.source(), tcp_packet.source_port() });
     if (!socket) {
+        ++statistics.packets_dropped;
+#ifdef TCP_DEBUG
         kprintf("handle_tcp: No TCP socket for port %u\n", tcp_packet.destination_port());
+#endif
         return;
     }
 
@@ -320,7 +381,10 @@ void handle_tcp(const EthernetFrameHeader& eth, int frame_size)
     ASSERT(socket->source_port() == tcp_packet.destination_port());
 
     if (tcp_packet.ack_number() != socket->sequence_number()) {
+        ++statistics.packets_dropped;
+#ifdef TCP_DEBUG
         kprintf("handle_tcp: ack/seq mismatch: got %u, wanted %u\n", tcp_packet.ack_number(), socket->sequence_number());
+#endif
         return;
     }
 
@@ -328,13 +392,17 @@ void handle_tcp(const EthernetFrameHeader& eth, int frame_size)
         socket->set_ack_number(tcp_packet.sequence_number() + payload_size + 1);
         socket->send_tcp_packet(TCPFlags::ACK);
         socket->set_connected(true);
+#ifdef TCP_DEBUG
         kprintf("handle_tcp: Connection established!\n");
+#endif
         socket->set_state(TCPSocket::State::Connected);
         return;
     }
 
     if (tcp_packet.has_fin()) {
+#ifdef TCP_DEBUG
         kprintf("handle_tcp: Got FIN, payload_size=%u\n", payload_size);
+#endif
 
         if (payload_size != 0)
             socket->did_receive(ByteBuffer::copy(&ipv4_packet, sizeof(IPv4Packet) + ipv4_packet.payload_size()));
@@ -346,6 +414,7 @@ void handle_tcp(const EthernetFrameHeader& eth, int frame_size)
     }
 
     socket->set_ack_number(tcp_packet.sequence_number() + payload_size);
+#ifdef TCP_DEBUG
     kprintf("Got packet with ack_no=%u, seq_no=%u, payload_size=%u, acking it with new ack_no=%u, seq_no=%u\n",
             tcp_packet.ack_number(),
             tcp_packet.sequence_number(),
@@ -353,6 +422,7 @@ void handle_tcp(const EthernetFrameHeader& eth, int frame_size)
             socket->ack_number(),
             socket->sequence_number()
             );
+#endif
     socket->send_tcp_packet(TCPFlags::ACK);
 
     if (payload_size != 0)
@@ -1,10 +1,60 @@
 #include <Kernel/Net/Routing.h>
-#include <Kernel/Net/LoopbackAdapter.h>
 
-NetworkAdapter* adapter_for_route_to(const IPv4Address& ipv4_address)
+RoutingTable& RoutingTable::the()
 {
-    // FIXME: Have an actual routing table.
-    if (ipv4_address == IPv4Address(127, 0, 0, 1))
-        return &LoopbackAdapter::the();
-    return NetworkAdapter::from_ipv4_address(IPv4Address(192, 168, 5, 2));
+    static RoutingTable* the;
+    if (!the)
+        the = new RoutingTable;
+    return *the;
+}
+
+static int prefix_length_of(dword netmask)
+{
+    // The mask is in network order, but we only care about how many bits are set.
+    int length = 0;
+    for (; netmask; netmask &= netmask - 1)
+        ++length;
+    return length;
+}
+
+void RoutingTable::add_route(const IPv4Address& destination, const IPv4Address& netmask, const IPv4Address& gateway, NetworkAdapter& adapter)
+{
+    Route route;
+    route.netmask = netmask.as_dword();
+    route.destination = destination.as_dword() & route.netmask;
+    route.prefix_length = prefix_length_of(route.netmask);
+    route.gateway = gateway;
+    route.adapter = &adapter;
+
+    LOCKER(m_routes.lock());
+    auto& routes = m_routes.resource();
+    int index = 0;
+    while (index < routes.size() && routes[index].prefix_length >= route.prefix_length)
+        ++index;
+    routes.insert(index, move(route));
+    ++m_generation;
+}
+
+void RoutingTable::remove_routes_for(NetworkAdapter& adapter)
+{
+    LOCKER(m_routes.lock());
+    auto& routes = m_routes.resource();
+    for (int i = routes.size() - 1; i >= 0; --i) {
+        if (routes[i].adapter == &adapter)
+            routes.remove(i);
+    }
+    ++m_generation;
+}
+
+RoutingDecision RoutingTable::route_to(const IPv4Address& target)
+{
+    LOCKER(m_routes.lock());
+    for (auto& route : m_routes.resource()) {
+        if ((target.as_dword() & route.netmask) != route.destination)
+            continue;
+        if (route.gateway == IPv4Address())
+            return { route.adapter, target };
+        return { route.adapter, route.gateway };
+    }
+    return { };
 }
@@ -1,5 +1,41 @@
 #pragma once
 
+#include <AK/Vector.h>
+#include <Kernel/Lock.h>
 #include <Kernel/Net/NetworkAdapter.h>
 
-NetworkAdapter* adapter_for_route_to(const IPv4Address&);
+struct RoutingDecision {
+    NetworkAdapter* adapter { nullptr };
+    IPv4Address next_hop;
+
+    bool is_valid() const { return adapter; }
+};
+
+class RoutingTable {
+public:
+    static RoutingTable& the();
+
+    // A zero gateway means the destination network is directly reachable through the adapter.
+    void add_route(const IPv4Address& destination, const IPv4Address& netmask, const IPv4Address& gateway, NetworkAdapter&);
+    void remove_routes_for(NetworkAdapter&);
+
+    RoutingDecision route_to(const IPv4Address&);
+
+    // Bumped whenever the table changes, so that callers can cache their routing decisions.
+    dword generation() const { return m_generation; }
+
+private:
+    RoutingTable() { }
+
+    struct Route {
+        dword destination { 0 };
+        dword netmask { 0 };
+        int prefix_length { 0 };
+        IPv4Address gateway;
+        NetworkAdapter* adapter { nullptr };
+    };
+
+    // Kept sorted by descending prefix length, so the first match is the longest prefix match.
+    Lockable<Vector<Route>> m_routes;
+    dword m_generation { 1 };
+};
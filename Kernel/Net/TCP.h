@@ -51,6 +51,8 @@ public:
     word urgent() const { return m_urgent; }
     void set_urgent(word urgent) { m_urgent = urgent; }
 
+    static size_t checksum_offset() { return __builtin_offsetof(TCPPacket, m_checksum); }
+
     const void* payload() const { return ((const byte*)this) + header_size(); }
     void* payload() { return ((byte*)this) + header_size(); }
 
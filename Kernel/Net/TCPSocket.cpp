@@ -5,26 +5,19 @@
 #include <Kernel/Process.h>
 #include <Kernel/Devices/RandomDevice.h>
 
-Lockable<HashMap<word, TCPSocket*>>& TCPSocket::sockets_by_port()
+//#define TCP_SOCKET_DEBUG
+
+IPv4SocketTable<TCPSocket>& TCPSocket::sockets()
 {
-    static Lockable<HashMap<word, TCPSocket*>>* s_map;
-    if (!s_map)
-        s_map = new Lockable<HashMap<word, TCPSocket*>>;
-    return *s_map;
+    static IPv4SocketTable<TCPSocket>* s_table;
+    if (!s_table)
+        s_table = new IPv4SocketTable<TCPSocket>;
+    return *s_table;
 }
 
-TCPSocketHandle TCPSocket::from_port(word port)
+TCPSocketHandle TCPSocket::from_tuple(const IPv4SocketTuple& tuple)
 {
-    RetainPtr<TCPSocket> socket;
-    {
-        LOCKER(sockets_by_port().lock());
-        auto it = sockets_by_port().resource().find(port);
-        if (it == sockets_by_port().resource().end())
-            return { };
-        socket = (*it).value;
-        ASSERT(socket);
-    }
-    return { move(socket) };
+    return { sockets().lookup(tuple) };
 }
 
 
@@ -35,8 +28,9 @@ TCPSocket::TCPSocket(int protocol)
 
 TCPSocket::~TCPSocket()
 {
-    LOCKER(sockets_by_port().lock());
-    sockets_by_port().resource().remove(source_port());
+    if (m_connection_tuple.local_port)
+        sockets().remove(m_connection_tuple, *this);
+    sockets().remove(IPv4SocketTuple::wildcard(source_port()), *this);
 }
 
 Retained<TCPSocket> TCPSocket::create(int protocol)
@@ -52,7 +46,9 @@ int TCPSocket::protocol_receive(const ByteBuffer& packet_buffer, void* buffer, s
     auto& ipv4_packet = *(const IPv4Packet*)(packet_buffer.pointer());
     auto& tcp_packet = *static_cast<const TCPPacket*>(ipv4_packet.payload());
     size_t payload_size = packet_buffer.size() - sizeof(IPv4Packet) - tcp_packet.header_size();
+#ifdef TCP_SOCKET_DEBUG
     kprintf("payload_size %u, will it fit in %u?\n", payload_size, buffer_size);
+#endif
     ASSERT(buffer_size >= payload_size);
     if (addr) {
         auto& ia = *(sockaddr_in*)addr;
@@ -64,8 +60,7 @@ int TCPSocket::protocol_receive(const ByteBuffer& packet_buffer, void* buffer, s
 
 int TCPSocket::protocol_send(const void* data, int data_length)
 {
-    auto* adapter = adapter_for_route_to(destination_address());
-    if (!adapter)
+    if (!route_to_destination().is_valid())
         return -EHOSTUNREACH;
     send_tcp_packet(TCPFlags::PUSH | TCPFlags::ACK, data, data_length);
     return data_length;
@@ -73,9 +68,9 @@ int TCPSocket::protocol_send(const void* data, int data_length)
 
 void TCPSocket::send_tcp_packet(word flags, const void* payload, int payload_size)
 {
-    // FIXME: Maybe the socket should be bound to an adapter instead of looking it up every time?
-    auto* adapter = adapter_for_route_to(destination_address());
-    ASSERT(adapter);
+    auto routing_decision = route_to_destination();
+    ASSERT(routing_decision.is_valid());
+    auto* adapter = routing_decision.adapter;
 
     auto buffer = ByteBuffer::create_zeroed(sizeof(TCPPacket) + payload_size);
     auto& tcp_packet = *(TCPPacket*)(buffer.pointer());
@@ -96,8 +91,19 @@ void TCPSocket::send_tcp_packet(word flags, const void* payload, int payload_siz
         m_sequence_number += payload_size;
     }
 
-    memcpy(tcp_packet.payload(), payload, payload_size);
-    tcp_packet.set_checksum(compute_tcp_checksum(adapter->ipv4_address(), destination_address(), tcp_packet, payload_size));
+    ASSERT(tcp_packet.data_offset() * 4 == sizeof(TCPPacket));
+    auto checksum = compute_tcp_pseudo_header_checksum(adapter->ipv4_address(), destination_address(), sizeof(TCPPacket) + payload_size);
+    bool offload_checksum = adapter->has_checksum_offload();
+    if (offload_checksum) {
+        // The adapter sums the header and payload for us, it just needs to be seeded with the pseudo-header.
+        memcpy(tcp_packet.payload(), payload, payload_size);
+        tcp_packet.set_checksum(checksum.partial());
+    } else {
+        checksum.add(&tcp_packet, sizeof(TCPPacket));
+        checksum.add_and_copy(tcp_packet.payload(), payload, payload_size);
+        tcp_packet.set_checksum(checksum.finish());
+    }
+#ifdef TCP_SOCKET_DEBUG
     kprintf("sending tcp packet from %s:%u to %s:%u with (%s %s) seq_no=%u, ack_no=%u\n",
         adapter->ipv4_address().to_string().characters(),
         source_port(),
@@ -108,57 +114,41 @@ void TCPSocket::send_tcp_packet(word flags, const void* payload, int payload_siz
         tcp_packet.sequence_number(),
         tcp_packet.ack_number()
     );
-    adapter->send_ipv4(MACAddress(), destination_address(), IPv4Protocol::TCP, move(buffer));
+#endif
+    adapter->send_ipv4_via(routing_decision.next_hop, destination_address(), IPv4Protocol::TCP, move(buffer), offload_checksum ? (int)TCPPacket::checksum_offset() : -1);
 }
 
-NetworkOrdered<word> TCPSocket::compute_tcp_checksum(const IPv4Address& source, const IPv4Address& destination, const TCPPacket& packet, word payload_size)
+InternetChecksum TCPSocket::compute_tcp_pseudo_header_checksum(const IPv4Address& source, const IPv4Address& destination, word tcp_length)
 {
     struct [[gnu::packed]] PseudoHeader {
         IPv4Address source;
         IPv4Address destination;
         byte zero;
         byte protocol;
-        NetworkOrdered<word> payload_size;
+        NetworkOrdered<word> tcp_length;
     };
 
-    PseudoHeader pseudo_header { source, destination, 0, (byte)IPv4Protocol::TCP, sizeof(TCPPacket) + payload_size };
-
-    dword checksum = 0;
-    auto* w = (const NetworkOrdered<word>*)&pseudo_header;
-    for (size_t i = 0; i < sizeof(pseudo_header) / sizeof(word); ++i) {
-        checksum += w[i];
-        if (checksum > 0xffff)
-            checksum = (checksum >> 16) + (checksum & 0xffff);
-    }
-    w = (const NetworkOrdered<word>*)&packet;
-    for (size_t i = 0; i < sizeof(packet) / sizeof(word); ++i) {
-        checksum += w[i];
-        if (checksum > 0xffff)
-            checksum = (checksum >> 16) + (checksum & 0xffff);
-    }
-    ASSERT(packet.data_offset() * 4 == sizeof(TCPPacket));
-    w = (const NetworkOrdered<word>*)packet.payload();
-    for (size_t i = 0; i < payload_size / sizeof(word); ++i) {
-        checksum += w[i];
-        if (checksum > 0xffff)
-            checksum = (checksum >> 16) + (checksum & 0xffff);
-    }
-    if (payload_size & 1) {
-        word expanded_byte = ((const byte*)packet.payload())[payload_size - 1] << 8;
-        checksum += expanded_byte;
-        if (checksum > 0xffff)
-            checksum = (checksum >> 16) + (checksum & 0xffff);
-    }
-    return ~(checksum & 0xffff);
+    PseudoHeader pseudo_header { source, destination, 0, (byte)IPv4Protocol::TCP, tcp_length };
+    InternetChecksum checksum;
+    checksum.add(&pseudo_header, sizeof(pseudo_header));
+    return checksum;
 }
 
 KResult TCPSocket::protocol_connect()
 {
-    auto* adapter = adapter_for_route_to(destination_address());
-    if (!adapter)
+    auto routing_decision = route_to_destination();
+    if (!routing_decision.is_valid())
         return KResult(-EHOSTUNREACH);
 
-    allocate_source_port_if_needed();
+    int rc = allocate_source_port_if_needed();
+    if (rc < 0)
+        return KResult(rc);
+
+    // Register the connection itself, so incoming segments from the peer find us without the port fallback.
+    IPv4SocketTuple tuple { routing_decision.adapter->ipv4_address(), source_port(), destination_address(), destination_port() };
+    if (!sockets().add(tuple, *this))
+        return KResult(-EADDRINUSE);
+    m_connection_tuple = tuple;
 
     m_sequence_number = 0;
     m_ack_number = 0;
@@ -180,12 +170,9 @@ int TCPSocket::protocol_allocate_source_port()
     static const word ephemeral_port_range_size = last_ephemeral_port - first_ephemeral_port;
     word first_scan_port = first_ephemeral_port + (word)(RandomDevice::random_percentage() * ephemeral_port_range_size);
 
-    LOCKER(sockets_by_port().lock());
     for (word port = first_scan_port;;) {
-        auto it = sockets_by_port().resource().find(port);
-        if (it == sockets_by_port().resource().end()) {
+        if (sockets().add(IPv4SocketTuple::wildcard(port), *this)) {
             set_source_port(port);
-            sockets_by_port().resource().set(port, this);
             return port;
         }
         ++port;
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <Kernel/Net/IPv4Socket.h>
+#include <Kernel/Net/IPv4SocketTable.h>
 
 class TCPSocket final : public IPv4Socket {
 public:
@@ -24,13 +25,13 @@ public:
 
     void send_tcp_packet(word flags, const void* = nullptr, int = 0);
 
-    static Lockable<HashMap<word, TCPSocket*>>& sockets_by_port();
-    static TCPSocketHandle from_port(word);
+    static IPv4SocketTable<TCPSocket>& sockets();
+    static TCPSocketHandle from_tuple(const IPv4SocketTuple&);
 
 private:
     explicit TCPSocket(int protocol);
 
-    NetworkOrdered<word> compute_tcp_checksum(const IPv4Address& source, const IPv4Address& destination, const TCPPacket&, word payload_size);
+    static InternetChecksum compute_tcp_pseudo_header_checksum(const IPv4Address& source, const IPv4Address& destination, word tcp_length);
 
     virtual int protocol_receive(const ByteBuffer&, void* buffer, size_t buffer_size, int flags, sockaddr* addr, socklen_t* addr_length) override;
     virtual int protocol_send(const void*, int) override;
@@ -41,6 +42,7 @@ private:
     dword m_sequence_number { 0 };
     dword m_ack_number { 0 };
     State m_state { State::Disconnected };
+    IPv4SocketTuple m_connection_tuple;
 };
 
 class TCPSocketHandle : public SocketHandle {
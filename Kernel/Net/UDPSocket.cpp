@@ -5,26 +5,19 @@
 #include <Kernel/Devices/RandomDevice.h>
 #include <Kernel/Net/Routing.h>
 
-Lockable<HashMap<word, UDPSocket*>>& UDPSocket::sockets_by_port()
+//#define UDP_SOCKET_DEBUG
+
+IPv4SocketTable<UDPSocket>& UDPSocket::sockets()
 {
-    static Lockable<HashMap<word, UDPSocket*>>* s_map;
-    if (!s_map)
-        s_map = new Lockable<HashMap<word, UDPSocket*>>;
-    return *s_map;
+    static IPv4SocketTable<UDPSocket>* s_table;
+    if (!s_table)
+        s_table = new IPv4SocketTable<UDPSocket>;
+    return *s_table;
 }
 
-UDPSocketHandle UDPSocket::from_port(word port)
+UDPSocketHandle UDPSocket::from_tuple(const IPv4SocketTuple& tuple)
 {
-    RetainPtr<UDPSocket> socket;
-    {
-        LOCKER(sockets_by_port().lock());
-        auto it = sockets_by_port().resource().find(port);
-        if (it == sockets_by_port().resource().end())
-            return { };
-        socket = (*it).value;
-        ASSERT(socket);
-    }
-    return { move(socket) };
+    return { sockets().lookup(tuple) };
 }
 
 
@@ -35,8 +28,7 @@ UDPSocket::UDPSocket(int protocol)
 
 UDPSocket::~UDPSocket()
 {
-    LOCKER(sockets_by_port().lock());
-    sockets_by_port().resource().remove(source_port());
+    sockets().remove(IPv4SocketTuple::wildcard(source_port()), *this);
 }
 
 Retained<UDPSocket> UDPSocket::create(int protocol)
@@ -63,21 +55,24 @@ int UDPSocket::protocol_receive(const ByteBuffer& packet_buffer, void* buffer, s
 
 int UDPSocket::protocol_send(const void* data, int data_length)
 {
-    auto* adapter = adapter_for_route_to(destination_address());
-    if (!adapter)
+    auto routing_decision = route_to_destination();
+    if (!routing_decision.is_valid())
         return -EHOSTUNREACH;
+    auto* adapter = routing_decision.adapter;
     auto buffer = ByteBuffer::create_zeroed(sizeof(UDPPacket) + data_length);
     auto& udp_packet = *(UDPPacket*)(buffer.pointer());
     udp_packet.set_source_port(source_port());
     udp_packet.set_destination_port(destination_port());
     udp_packet.set_length(sizeof(UDPPacket) + data_length);
     memcpy(udp_packet.payload(), data, data_length);
+#ifdef UDP_SOCKET_DEBUG
     kprintf("sending as udp packet from %s:%u to %s:%u!\n",
         adapter->ipv4_address().to_string().characters(),
         source_port(),
         destination_address().to_string().characters(),
         destination_port());
-    adapter->send_ipv4(MACAddress(), destination_address(), IPv4Protocol::UDP, move(buffer));
+#endif
+    adapter->send_ipv4_via(routing_decision.next_hop, destination_address(), IPv4Protocol::UDP, move(buffer));
     return data_length;
 }
 
@@ -93,12 +88,9 @@ int UDPSocket::protocol_allocate_source_port()
     static const word ephemeral_port_range_size = last_ephemeral_port - first_ephemeral_port;
     word first_scan_port = first_ephemeral_port + (word)(RandomDevice::random_percentage() * ephemeral_port_range_size);
 
-    LOCKER(sockets_by_port().lock());
     for (word port = first_scan_port;;) {
-        auto it = sockets_by_port().resource().find(port);
-        if (it == sockets_by_port().resource().end()) {
+        if (sockets().add(IPv4SocketTuple::wildcard(port), *this)) {
             set_source_port(port);
-            sockets_by_port().resource().set(port, this);
             return port;
         }
         ++port;
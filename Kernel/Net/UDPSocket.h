@@ -1,6 +1,7 @@
 #pragma once
 
 #include <Kernel/Net/IPv4Socket.h>
+#include <Kernel/Net/IPv4SocketTable.h>
 
 class UDPSocketHandle;
 
@@ -9,8 +10,8 @@ public:
     static Retained<UDPSocket> create(int protocol);
     virtual ~UDPSocket() override;
 
-    static Lockable<HashMap<word, UDPSocket*>>& sockets_by_port();
-    static UDPSocketHandle from_port(word);
+    static IPv4SocketTable<UDPSocket>& sockets();
+    static UDPSocketHandle from_tuple(const IPv4SocketTuple&);
 
 private:
     explicit UDPSocket(int protocol);
@@ -32,6 +32,7 @@
 
 static pid_t next_pid;
 InlineLinkedList<Process>* g_processes;
+dword g_processes_generation;
 static String* s_hostname;
 static Lock* s_hostname_lock;
 
@@ -258,6 +259,7 @@ Process* Process::fork(RegisterDump& regs)
     {
         InterruptDisabler disabler;
         g_processes->prepend(child);
+        ++g_processes_generation;
     }
 #ifdef TASK_DEBUG
     kprintf("Process %u (%s) forked from %u @ %p\n", child->pid(), child->name().characters(), m_pid, child_tss.eip);
@@ -505,6 +507,7 @@ Process* Process::create_user_process(const String& path, uid_t uid, gid_t gid,
     {
         InterruptDisabler disabler;
         g_processes->prepend(process);
+        ++g_processes_generation;
     }
 #ifdef TASK_DEBUG
     kprintf("Process %u (%s) spawned @ %p\n", process->pid(), process->name().characters(), process->main_thread().tss().eip);
@@ -521,6 +524,7 @@ Process* Process::create_kernel_process(String&& name, void (*e)())
     if (process->pid() != 0) {
         InterruptDisabler disabler;
         g_processes->prepend(process);
+        ++g_processes_generation;
 #ifdef TASK_DEBUG
         kprintf("Kernel process %u (%s) spawned @ %p\n", process->pid(), process->name().characters(), process->main_thread().tss().eip);
 #endif
@@ -756,6 +760,18 @@ ssize_t Process::sys$get_dir_entries(int fd, void* buffer, ssize_t size)
     return descriptor->get_dir_entries((byte*)buffer, size);
 }
 
+ssize_t Process::sys$get_dir_entries_with_stat(int fd, void* buffer, ssize_t size)
+{
+    if (size < 0)
+        return -EINVAL;
+    if (!validate_write(buffer, size))
+        return -EFAULT;
+    auto* descriptor = file_descriptor(fd);
+    if (!descriptor)
+        return -EBADF;
+    return descriptor->get_dir_entries_with_stat((byte*)buffer, size);
+}
+
 int Process::sys$lseek(int fd, off_t offset, int whence)
 {
     auto* descriptor = file_descriptor(fd);
@@ -1291,6 +1307,7 @@ int Process::reap(Process& process)
         dbgprintf("reap: %s(%u) {%s}\n", process.name().characters(), process.pid(), to_string(process.state()));
         ASSERT(process.is_dead());
         g_processes->remove(&process);
+        ++g_processes_generation;
     }
     delete &process;
     return exit_status;
@@ -129,6 +129,7 @@ public:
     int sys$select(const Syscall::SC_select_params*);
     int sys$poll(pollfd*, int nfds, int timeout);
     ssize_t sys$get_dir_entries(int fd, void*, ssize_t);
+    ssize_t sys$get_dir_entries_with_stat(int fd, void*, ssize_t);
     int sys$getcwd(char*, ssize_t);
     int sys$chdir(const char*);
     int sys$sleep(unsigned seconds);
@@ -356,6 +357,8 @@ private:
 extern const char* to_string(Process::Priority);
 
 extern InlineLinkedList<Process>* g_processes;
+// Bumped whenever a process is added to or removed from g_processes.
+extern dword g_processes_generation;
 
 template<typename Callback>
 inline void Process::for_each(Callback callback)
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <AK/Types.h>
+
+// /proc/all_binary is a ProcessStatisticsHeader followed by 'process_count' ProcessStatistics records.
+// It carries the same information as /proc/all, but can be consumed with a single read() and no parsing.
+
+#define PROCESS_STATISTICS_VERSION 1
+
+struct ProcessStatisticsHeader {
+    dword version;
+    dword record_size;
+    dword process_count;
+    // Changes whenever a process is created or reaped. If it's the same as last time,
+    // so is the set of pids in the snapshot.
+    dword generation;
+};
+
+struct ProcessStatistics {
+    dword pid;
+    dword times_scheduled;
+    dword pgid;
+    dword tty_pgid;
+    dword sid;
+    dword uid;
+    dword gid;
+    dword ppid;
+    dword file_descriptor_count;
+    dword amount_virtual;
+    dword amount_resident;
+    dword amount_shared;
+    dword ticks;
+    // All strings are null-terminated, and truncated if they don't fit.
+    char state[16];
+    char priority[8];
+    char tty[16];
+    char name[32];
+};
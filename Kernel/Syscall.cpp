@@ -72,6 +72,8 @@ static dword handle(RegisterDump& regs, dword function, dword arg1, dword arg2,
         return current->process().sys$gettimeofday((timeval*)arg1);
     case Syscall::SC_get_dir_entries:
         return current->process().sys$get_dir_entries((int)arg1, (void*)arg2, (size_t)arg3);
+    case Syscall::SC_get_dir_entries_with_stat:
+        return current->process().sys$get_dir_entries_with_stat((int)arg1, (void*)arg2, (size_t)arg3);
     case Syscall::SC_lstat:
         return current->process().sys$lstat((const char*)arg1, (stat*)arg2);
     case Syscall::SC_stat:
@@ -79,6 +79,11 @@ cp -v ../Userland/uc mnt/bin/uc
 cp -v ../Userland/tc mnt/bin/tc
 cp -v ../Userland/host mnt/bin/host
 cp -v ../Userland/qs mnt/bin/qs
+cp -v ../Userland/blendbench mnt/bin/blendbench
+cp -v ../Userland/ipcbench mnt/bin/ipcbench
+cp -v ../Userland/textbench mnt/bin/textbench
+cp -v ../Userland/pngbench mnt/bin/pngbench
+cp -v ../Userland/tablebench mnt/bin/tablebench
 chmod 4755 mnt/bin/su
 cp -v ../Applications/Terminal/Terminal mnt/bin/Terminal
 cp -v ../Applications/FontEditor/FontEditor mnt/bin/FontEditor
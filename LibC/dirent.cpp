@@ -22,6 +22,7 @@ DIR* opendir(const char* name)
     dirp->buffer = nullptr;
     dirp->buffer_size = 0;
     dirp->nextptr = nullptr;
+    dirp->buffer_has_stat = 0;
     return dirp;
 }
 
@@ -49,25 +50,43 @@ struct [[gnu::packed]] sys_dirent {
     }
 };
 
-dirent* readdir(DIR* dirp)
+static bool fill_buffer(DIR* dirp, bool with_stat)
 {
-    if (!dirp)
-        return nullptr;
-    if (dirp->fd == -1)
-        return nullptr;
-
-    if (!dirp->buffer) {
-        struct stat st;
-        int rc = fstat(dirp->fd, &st);
-        if (rc < 0)
-            return nullptr;
-        size_t size_to_allocate = max(st.st_size, 4096);
+    struct stat st;
+    int rc = fstat(dirp->fd, &st);
+    if (rc < 0)
+        return false;
+    size_t size_to_allocate = max(st.st_size, 4096);
+    if (!with_stat) {
         dirp->buffer = (char*)malloc(size_to_allocate);
         ssize_t nread = syscall(SC_get_dir_entries, dirp->fd, dirp->buffer, size_to_allocate);
         dirp->buffer_size = nread;
         dirp->nextptr = dirp->buffer;
+        return true;
     }
+    for (;;) {
+        dirp->buffer = (char*)malloc(size_to_allocate);
+        ssize_t nread = syscall(SC_get_dir_entries_with_stat, dirp->fd, dirp->buffer, size_to_allocate);
+        if (nread == -ERANGE) {
+            free(dirp->buffer);
+            size_to_allocate *= 2;
+            continue;
+        }
+        if (nread < 0) {
+            free(dirp->buffer);
+            dirp->buffer = nullptr;
+            errno = -nread;
+            return false;
+        }
+        dirp->buffer_size = nread;
+        dirp->nextptr = dirp->buffer;
+        dirp->buffer_has_stat = 1;
+        return true;
+    }
+}
 
+static dirent* read_next_entry(DIR* dirp, struct stat* st)
+{
     if (dirp->nextptr >= (dirp->buffer + dirp->buffer_size))
         return nullptr;
 
@@ -82,8 +101,41 @@ dirent* readdir(DIR* dirp)
     dirp->cur_ent.d_name[sys_ent->namelen] = '\0';
 
     dirp->nextptr += sys_ent->total_size();
+    if (dirp->buffer_has_stat) {
+        if (st)
+            memcpy(st, dirp->nextptr, sizeof(struct stat));
+        dirp->nextptr += sizeof(struct stat);
+    }
     return &dirp->cur_ent;
 }
 
+dirent* readdir(DIR* dirp)
+{
+    if (!dirp)
+        return nullptr;
+    if (dirp->fd == -1)
+        return nullptr;
+
+    if (!dirp->buffer && !fill_buffer(dirp, false))
+        return nullptr;
+    return read_next_entry(dirp, nullptr);
+}
+
+dirent* readdir_with_stat(DIR* dirp, struct stat* st)
+{
+    if (!dirp)
+        return nullptr;
+    if (dirp->fd == -1)
+        return nullptr;
+
+    if (dirp->buffer && !dirp->buffer_has_stat) {
+        errno = EINVAL;
+        return nullptr;
+    }
+    if (!dirp->buffer && !fill_buffer(dirp, true))
+        return nullptr;
+    return read_next_entry(dirp, st);
+}
+
 }
 
@@ -19,6 +19,7 @@ struct __DIR {
     char* buffer;
     size_t buffer_size;
     char* nextptr;
+    int buffer_has_stat;
 };
 typedef struct __DIR DIR;
 
@@ -26,5 +27,12 @@ DIR* opendir(const char* name);
 int closedir(DIR*);
 struct dirent* readdir(DIR*);
 
+struct stat;
+
+// Like readdir(), but also fills in 'st' as lstat() would, without a path lookup per entry.
+// The whole directory is fetched along with its metadata in one call, so don't mix this with
+// readdir() on the same DIR.
+struct dirent* readdir_with_stat(DIR*, struct stat* st);
+
 __END_DECLS
 
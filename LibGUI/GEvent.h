@@ -28,6 +28,7 @@ public:
         KeyUp,
         Timer,
         DeferredDestroy,
+        DeferredInvalidate,
         WindowEntered,
         WindowLeft,
         WindowBecameInactive,
@@ -35,6 +36,7 @@ public:
         FocusIn,
         FocusOut,
         WindowCloseRequest,
+        FrameCallback,
         ChildAdded,
         ChildRemoved,
         WM_WindowRemoved,
@@ -27,8 +27,13 @@ static Vector<GEventLoop*>* s_event_loop_stack;
 int GEventLoop::s_event_fd = -1;
 pid_t GEventLoop::s_server_pid = -1;
 HashMap<int, OwnPtr<GEventLoop::EventLoopTimer>>* GEventLoop::s_timers;
+BinaryHeap<qword, int>* GEventLoop::s_timer_queue;
 HashTable<GNotifier*>* GEventLoop::s_notifiers;
+Vector<byte>* GEventLoop::s_outgoing_buffer;
+Vector<byte>* GEventLoop::s_incoming_buffer;
 int GEventLoop::s_next_timer_id = 1;
+int GEventLoop::s_timer_slack_ms = 0;
+GEventLoop::TimerStatistics GEventLoop::s_timer_statistics;
 
 void GEventLoop::connect_to_server()
 {
@@ -72,7 +77,10 @@ GEventLoop::GEventLoop()
     if (!s_event_loop_stack) {
         s_event_loop_stack = new Vector<GEventLoop*>;
         s_timers = new HashMap<int, OwnPtr<GEventLoop::EventLoopTimer>>;
+        s_timer_queue = new BinaryHeap<qword, int>;
         s_notifiers = new HashTable<GNotifier*>;
+        s_outgoing_buffer = new Vector<byte>;
+        s_incoming_buffer = new Vector<byte>;
     }
 
     if (!s_main_event_loop) {
@@ -136,6 +144,7 @@ int GEventLoop::exec()
 
     m_running = true;
     for (;;) {
+        flush_messages_to_server();
         if (m_exit_requested)
             return m_exit_code;
         process_unprocessed_messages();
@@ -207,6 +216,11 @@ void GEventLoop::handle_window_close_request_event(const WSAPI_ServerMessage&, G
     post_event(window, make<GEvent>(GEvent::WindowCloseRequest));
 }
 
+void GEventLoop::handle_frame_callback_event(const WSAPI_ServerMessage&, GWindow& window)
+{
+    post_event(window, make<GEvent>(GEvent::FrameCallback));
+}
+
 void GEventLoop::handle_window_entered_or_left_event(const WSAPI_ServerMessage& message, GWindow& window)
 {
     post_event(window, make<GEvent>(message.type == WSAPI_ServerMessage::Type::WindowEntered ? GEvent::WindowEntered : GEvent::WindowLeft));
@@ -282,6 +296,8 @@ void GEventLoop::handle_wm_event(const WSAPI_ServerMessage& event, GWindow& wind
 
 void GEventLoop::wait_for_event()
 {
+    flush_messages_to_server();
+
     fd_set rfds;
     fd_set wfds;
     FD_ZERO(&rfds);
@@ -305,29 +321,15 @@ void GEventLoop::wait_for_event()
     }
 
     struct timeval timeout = { 0, 0 };
-    if (!s_timers->is_empty() && m_queued_events.is_empty())
+    if (!s_timer_queue->is_empty() && m_queued_events.is_empty())
         get_next_timer_expiration(timeout);
     ASSERT(m_unprocessed_messages.is_empty());
-    int rc = select(max_fd + 1, &rfds, &wfds, nullptr, (m_queued_events.is_empty() && s_timers->is_empty()) ? nullptr : &timeout);
+    int rc = select(max_fd + 1, &rfds, &wfds, nullptr, (m_queued_events.is_empty() && s_timer_queue->is_empty()) ? nullptr : &timeout);
     if (rc < 0) {
         ASSERT_NOT_REACHED();
     }
 
-    for (auto& it : *s_timers) {
-        auto& timer = *it.value;
-        if (!timer.has_expired())
-            continue;
-#ifdef GEVENTLOOP_DEBUG
-        dbgprintf("GEventLoop: Timer %d has expired, sending GTimerEvent to %p\n", timer.timer_id, timer.owner);
-#endif
-        post_event(*timer.owner, make<GTimerEvent>(timer.timer_id));
-        if (timer.should_reload) {
-            timer.reload();
-        } else {
-            // FIXME: Support removing expired timers that don't want to reload.
-            ASSERT_NOT_REACHED();
-        }
-    }
+    fire_expired_timers();
 
     for (auto& notifier : *s_notifiers) {
         if (FD_ISSET(notifier->fd(), &rfds)) {
@@ -398,6 +400,9 @@ void GEventLoop::process_unprocessed_messages()
         case WSAPI_ServerMessage::Type::WindowCloseRequest:
             handle_window_close_request_event(event, *window);
             break;
+        case WSAPI_ServerMessage::Type::FrameCallback:
+            handle_frame_callback_event(event, *window);
+            break;
         case WSAPI_ServerMessage::Type::KeyDown:
         case WSAPI_ServerMessage::Type::KeyUp:
             handle_key_event(event, *window);
@@ -424,10 +429,13 @@ void GEventLoop::process_unprocessed_messages()
 
 bool GEventLoop::drain_messages_from_server()
 {
+    auto& buffer = *s_incoming_buffer;
     bool is_first_pass = true;
     for (;;) {
-        WSAPI_ServerMessage message;
-        ssize_t nread = read(s_event_fd, &message, sizeof(WSAPI_ServerMessage));
+        int old_size = buffer.size();
+        buffer.resize(old_size + 4096);
+        ssize_t nread = read(s_event_fd, buffer.data() + old_size, 4096);
+        buffer.resize(old_size + max(nread, (ssize_t)0));
         if (nread < 0) {
             perror("read");
             quit(1);
@@ -439,37 +447,89 @@ bool GEventLoop::drain_messages_from_server()
                 quit(1);
                 return false;
             }
-            return true;
+            break;
         }
-        assert(nread == sizeof(message));
-        m_unprocessed_messages.append(move(message));
         is_first_pass = false;
     }
+
+    int offset = 0;
+    for (;;) {
+        WSAPI_ServerMessage message;
+        int consumed = wsapi_decode_message(buffer.data() + offset, buffer.size() - offset, message);
+        if (!consumed)
+            break;
+        if (consumed < 0) {
+            fprintf(stderr, "Malformed message on WindowServer fd\n");
+            quit(1);
+            return false;
+        }
+        m_unprocessed_messages.append(move(message));
+        offset += consumed;
+    }
+    wsapi_consume(buffer, offset);
+    return true;
 }
 
-bool GEventLoop::EventLoopTimer::has_expired() const
+static qword current_time_in_microseconds()
 {
     timeval now;
     gettimeofday(&now, nullptr);
-    return now.tv_sec > fire_time.tv_sec || (now.tv_sec == fire_time.tv_sec && now.tv_usec >= fire_time.tv_usec);
+    return (qword)now.tv_sec * 1000000 + now.tv_usec;
+}
+
+void GEventLoop::EventLoopTimer::reload(qword now)
+{
+    fire_time = now + (qword)interval * 1000;
 }
 
-void GEventLoop::EventLoopTimer::reload()
+void GEventLoop::get_next_timer_expiration(timeval& timeout)
 {
-    gettimeofday(&fire_time, nullptr);
-    fire_time.tv_sec += interval / 1000;
-    fire_time.tv_usec += (interval % 1000) * 1000;
+    // Drop the entries of unregistered timers first, so the front of the queue is a live timer.
+    while (!s_timer_queue->is_empty() && !s_timers->contains(s_timer_queue->peek_min()))
+        s_timer_queue->pop_min();
+    timeout = { 0, 0 };
+    if (s_timer_queue->is_empty())
+        return;
+    qword wake_time = s_timer_queue->peek_min_key() + (qword)s_timer_slack_ms * 1000;
+    qword now = current_time_in_microseconds();
+    if (wake_time <= now)
+        return;
+    // Cap the wait to keep the arithmetic in 32 bits. A longer timer just costs an extra wakeup.
+    dword delay = min(wake_time - now, (qword)1000000000);
+    timeout = { (time_t)(delay / 1000000), (suseconds_t)(delay % 1000000) };
 }
 
-void GEventLoop::get_next_timer_expiration(timeval& soonest)
+void GEventLoop::fire_expired_timers()
 {
-    ASSERT(!s_timers->is_empty());
-    bool has_checked_any = false;
-    for (auto& it : *s_timers) {
-        auto& fire_time = it.value->fire_time;
-        if (!has_checked_any || fire_time.tv_sec < soonest.tv_sec || (fire_time.tv_sec == soonest.tv_sec && fire_time.tv_usec < soonest.tv_usec))
-            soonest = fire_time;
-        has_checked_any = true;
+    qword now = current_time_in_microseconds();
+    // Take everything that's due before reloading anything, so a 0ms timer can't keep this loop going forever.
+    Vector<int> expired_timer_ids;
+    while (!s_timer_queue->is_empty() && s_timer_queue->peek_min_key() <= now) {
+        qword fire_time = s_timer_queue->peek_min_key();
+        int timer_id = s_timer_queue->pop_min();
+        if (!s_timers->contains(timer_id))
+            continue;
+        expired_timer_ids.append(timer_id);
+        dword lateness = now - fire_time;
+        ++s_timer_statistics.fired;
+        s_timer_statistics.total_lateness_us += lateness;
+        s_timer_statistics.max_lateness_us = max(s_timer_statistics.max_lateness_us, lateness);
+    }
+    for (int timer_id : expired_timer_ids) {
+        auto it = s_timers->find(timer_id);
+        ASSERT(it != s_timers->end());
+        auto& timer = *(*it).value;
+#ifdef GEVENTLOOP_DEBUG
+        dbgprintf("GEventLoop: Timer %d has expired, sending GTimerEvent to %p\n", timer.timer_id, timer.owner.ptr());
+#endif
+        if (timer.owner)
+            post_event(*timer.owner, make<GTimerEvent>(timer.timer_id));
+        if (timer.should_reload && timer.owner) {
+            timer.reload(now);
+            s_timer_queue->insert(timer.fire_time, timer_id);
+        } else {
+            s_timers->remove(it);
+        }
     }
 }
 
@@ -479,11 +539,12 @@ int GEventLoop::register_timer(GObject& object, int milliseconds, bool should_re
     auto timer = make<EventLoopTimer>();
     timer->owner = object.make_weak_ptr();
     timer->interval = milliseconds;
-    timer->reload();
+    timer->reload(current_time_in_microseconds());
     timer->should_reload = should_reload;
     int timer_id = ++s_next_timer_id;  // FIXME: This will eventually wrap around.
     ASSERT(timer_id); // FIXME: Aforementioned wraparound.
     timer->timer_id = timer_id;
+    s_timer_queue->insert(timer->fire_time, timer_id);
     s_timers->set(timer->timer_id, move(timer));
     return timer_id;
 }
@@ -509,12 +570,29 @@ void GEventLoop::unregister_notifier(Badge<GNotifier>, GNotifier& notifier)
 
 bool GEventLoop::post_message_to_server(const WSAPI_ClientMessage& message)
 {
-    int nwritten = write(s_event_fd, &message, sizeof(WSAPI_ClientMessage));
-    return nwritten == sizeof(WSAPI_ClientMessage);
+    wsapi_encode_message(*s_outgoing_buffer, message);
+    return true;
+}
+
+bool GEventLoop::flush_messages_to_server()
+{
+    auto& buffer = *s_outgoing_buffer;
+    if (buffer.is_empty())
+        return true;
+    int nwritten = write(s_event_fd, buffer.data(), buffer.size());
+    bool success = nwritten == buffer.size();
+    // Hang on to the buffer for next time, unless some burst made it unreasonably big.
+    if (buffer.capacity() <= 16384)
+        buffer.clear_with_capacity();
+    else
+        buffer.clear();
+    return success;
 }
 
 bool GEventLoop::wait_for_specific_event(WSAPI_ServerMessage::Type type, WSAPI_ServerMessage& event)
 {
+    if (!flush_messages_to_server())
+        return false;
 
     for (;;) {
         fd_set rfds;
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <AK/Badge.h>
+#include <AK/BinaryHeap.h>
 #include <AK/HashMap.h>
 #include <AK/OwnPtr.h>
 #include <AK/Vector.h>
@@ -30,12 +31,25 @@ public:
     static int register_timer(GObject&, int milliseconds, bool should_reload);
     static bool unregister_timer(int timer_id);
 
+    // Lets timers fire up to 'ms' late, so that timers due close together are handled on one wakeup.
+    static void set_timer_slack(int ms) { s_timer_slack_ms = ms; }
+
+    struct TimerStatistics {
+        unsigned fired { 0 };
+        qword total_lateness_us { 0 };
+        dword max_lateness_us { 0 };
+    };
+    static const TimerStatistics& timer_statistics() { return s_timer_statistics; }
+
     static void register_notifier(Badge<GNotifier>, GNotifier&);
     static void unregister_notifier(Badge<GNotifier>, GNotifier&);
 
     void quit(int);
 
+    // Messages to the server are batched up, and only written out when the event loop
+    // is about to wait for something, or by flush_messages_to_server().
     static bool post_message_to_server(const WSAPI_ClientMessage&);
+    static bool flush_messages_to_server();
     bool wait_for_specific_event(WSAPI_ServerMessage::Type, WSAPI_ServerMessage&);
 
     WSAPI_ServerMessage sync_request(const WSAPI_ClientMessage& request, WSAPI_ServerMessage::Type response_type);
@@ -58,10 +72,12 @@ private:
     void handle_key_event(const WSAPI_ServerMessage&, GWindow&);
     void handle_window_activation_event(const WSAPI_ServerMessage&, GWindow&);
     void handle_window_close_request_event(const WSAPI_ServerMessage&, GWindow&);
+    void handle_frame_callback_event(const WSAPI_ServerMessage&, GWindow&);
     void handle_menu_event(const WSAPI_ServerMessage&);
     void handle_window_entered_or_left_event(const WSAPI_ServerMessage&, GWindow&);
     void handle_wm_event(const WSAPI_ServerMessage&, GWindow&);
     void get_next_timer_expiration(timeval&);
+    void fire_expired_timers();
     void connect_to_server();
 
     struct QueuedEvent {
@@ -82,16 +98,22 @@ private:
     struct EventLoopTimer {
         int timer_id { 0 };
         int interval { 0 };
-        timeval fire_time;
+        qword fire_time { 0 }; // In microseconds since the epoch.
         bool should_reload { false };
         WeakPtr<GObject> owner;
 
-        void reload();
-        bool has_expired() const;
+        void reload(qword now);
     };
 
     static HashMap<int, OwnPtr<EventLoopTimer>>* s_timers;
+    // Timer ids by fire time. Unregistering a timer leaves its entry here; it's dropped when it reaches the front.
+    static BinaryHeap<qword, int>* s_timer_queue;
     static int s_next_timer_id;
+    static int s_timer_slack_ms;
+    static TimerStatistics s_timer_statistics;
 
     static HashTable<GNotifier*>* s_notifiers;
+
+    static Vector<byte>* s_outgoing_buffer;
+    static Vector<byte>* s_incoming_buffer;
 };
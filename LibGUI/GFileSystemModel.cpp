@@ -37,15 +37,10 @@ struct GFileSystemModel::Node {
         if (!dirp)
             return;
 
-        while (auto* de = readdir(dirp)) {
+        struct stat st;
+        while (auto* de = readdir_with_stat(dirp, &st)) {
             if (!strcmp(de->d_name, ".") || !strcmp(de->d_name, ".."))
                 continue;
-            struct stat st;
-            int rc = lstat(String::format("%s/%s", full_path.characters(), de->d_name).characters(), &st);
-            if (rc < 0) {
-                perror("lstat");
-                continue;
-            }
             if (model.m_mode == DirectoriesOnly && !S_ISDIR(st.st_mode))
                 continue;
             auto* child = new Node;
@@ -66,7 +61,6 @@ struct GFileSystemModel::Node {
         struct stat st;
         auto full_path = this->full_path(model);
         int rc = lstat(full_path.characters(), &st);
-        dbgprintf("lstat(%s) = %d\n", full_path.characters(), rc);
         if (rc < 0) {
             perror("lstat");
             return;
@@ -69,12 +69,13 @@ Rect GItemView::item_rect(int item_index) const
 void GItemView::mousedown_event(GMouseEvent& event)
 {
     if (event.button() == GMouseButton::Left) {
-        // FIXME: Since all items are the same size, just compute the clicked item index
-        //        instead of iterating over everything.
         auto adjusted_position = event.position().translated(0, vertical_scrollbar().value());
-        for (int i = 0; i < item_count(); ++i) {
-            if (item_rect(i).contains(adjusted_position)) {
-                model()->set_selected_index(model()->index(i, 0));
+        if (m_visual_column_count && adjusted_position.x() >= 0 && adjusted_position.y() >= 0) {
+            int visual_column_index = adjusted_position.x() / effective_item_size().width();
+            int visual_row_index = adjusted_position.y() / effective_item_size().height();
+            int item_index = visual_row_index * m_visual_column_count + visual_column_index;
+            if (visual_column_index < m_visual_column_count && item_index < item_count()) {
+                model()->set_selected_index(model()->index(item_index, 0));
                 update();
                 return;
             }
@@ -107,8 +108,20 @@ void GItemView::paint_event(GPaintEvent& event)
     auto column_metadata = model()->column_metadata(m_model_column);
     const Font& font = column_metadata.font ? *column_metadata.font : this->font();
 
-    for (int item_index = 0; item_index < model()->row_count(); ++item_index) {
-        bool is_selected_item = item_index == model()->selected_index().row();
+    if (!m_visual_row_count || !m_visual_column_count)
+        return;
+
+    // Items are laid out in a grid, so only the visual rows that intersect the paint rect need painting.
+    auto paint_rect = event.rect().translated(horizontal_scrollbar().value(), vertical_scrollbar().value());
+    int item_height = effective_item_size().height();
+    int first_visual_row = max(0, paint_rect.top() / item_height - 1);
+    int last_visual_row = min(m_visual_row_count - 1, paint_rect.bottom() / item_height + 1);
+    int first_item_index = first_visual_row * m_visual_column_count;
+    int end_item_index = min(model()->row_count(), (last_visual_row + 1) * m_visual_column_count);
+    int selected_item_index = model()->selected_index().row();
+
+    for (int item_index = first_item_index; item_index < end_item_index; ++item_index) {
+        bool is_selected_item = item_index == selected_item_index;
         Color background_color;
         if (is_selected_item) {
             background_color = is_focused() ? Color::from_rgb(0x84351a) : Color::from_rgb(0x606060);
@@ -131,7 +144,10 @@ void GItemView::paint_event(GPaintEvent& event)
                 painter.draw_scaled_bitmap(icon_rect, *bitmap, bitmap->rect());
         }
 
-        Rect text_rect { 0, icon_rect.bottom() + 6 + 1, font.width(item_text.to_string()), font.glyph_height() };
+        GVariant::TextBuffer text_buffer;
+        int text_length;
+        auto* text = item_text.to_text(text_buffer, text_length);
+        Rect text_rect { 0, icon_rect.bottom() + 6 + 1, font.width(text, text_length), font.glyph_height() };
         text_rect.center_horizontally_within(item_rect);
         text_rect.inflate(6, 4);
 
@@ -141,7 +157,7 @@ void GItemView::paint_event(GPaintEvent& event)
         else
             text_color = model()->data(model_index, GModel::Role::ForegroundColor).to_color(Color::Black);
         painter.fill_rect(text_rect, background_color);
-        painter.draw_text(text_rect, item_text.to_string(), font, TextAlignment::Center, text_color);
+        painter.draw_text(text_rect, text, text_length, font, TextAlignment::Center, text_color);
     };
 }
 
@@ -8,10 +8,15 @@ GPainter::GPainter(GraphicsBitmap& bitmap)
 }
 
 GPainter::GPainter(GWidget& widget)
-    : Painter(*widget.window()->back_bitmap())
+    : GPainter(widget, widget.paint_target())
+{
+}
+
+GPainter::GPainter(GWidget& widget, const GWidget::PaintTarget& target)
+    : Painter(*target.bitmap)
 {
     state().font = &widget.font();
-    auto origin_rect = widget.window_relative_rect();
+    Rect origin_rect { target.origin, widget.size() };
     state().translation = origin_rect.location();
     state().clip_rect = origin_rect;
     m_clip_origin = origin_rect;
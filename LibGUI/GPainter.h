@@ -1,12 +1,15 @@
 #pragma once
 
+#include <LibGUI/GWidget.h>
 #include <SharedGraphics/Painter.h>
 
-class GWidget;
 class GraphicsBitmap;
 
 class GPainter : public Painter {
 public:
     explicit GPainter(GWidget&);
     explicit GPainter(GraphicsBitmap&);
+
+private:
+    GPainter(GWidget&, const GWidget::PaintTarget&);
 };
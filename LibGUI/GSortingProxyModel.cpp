@@ -1,5 +1,5 @@
 #include <LibGUI/GSortingProxyModel.h>
-#include <AK/QuickSort.h>
+#include <AK/MergeSort.h>
 #include <stdlib.h>
 #include <stdio.h>
 
@@ -80,19 +80,27 @@ void GSortingProxyModel::resort()
 {
     int previously_selected_target_row = map_to_target(selected_index()).row();
     int row_count = target().row_count();
-    m_row_mappings.resize(row_count);
-    for (int i = 0; i < row_count; ++i)
-        m_row_mappings[i] = i;
+    // Keep the previous order as the starting point when we can. Models like ProcessManager's
+    // change only a few rows between updates, and merge_sort() doesn't merge runs that are already in order.
+    if (m_key_column == -1 || m_row_mappings.size() != row_count) {
+        m_row_mappings.resize(row_count);
+        for (int i = 0; i < row_count; ++i)
+            m_row_mappings[i] = i;
+    }
     if (m_key_column == -1)
         return;
-    quick_sort(m_row_mappings.begin(), m_row_mappings.end(), [&] (auto row1, auto row2) -> bool {
-        auto data1 = target().data(target().index(row1, m_key_column), GModel::Role::Sort);
-        auto data2 = target().data(target().index(row2, m_key_column), GModel::Role::Sort);
-        if (data1 == data2)
-            return 0;
-        bool is_less_than = data1 < data2;
-        return m_sort_order == GSortOrder::Ascending ? is_less_than : !is_less_than;
-    });
+
+    // Fetch every sort key once up front instead of twice per comparison.
+    Vector<GVariant> keys;
+    keys.ensure_capacity(row_count);
+    for (int i = 0; i < row_count; ++i)
+        keys.append(target().data(target().index(i, m_key_column), GModel::Role::Sort));
+
+    if (m_sort_order == GSortOrder::Ascending)
+        merge_sort(m_row_mappings, [&] (int row1, int row2) { return keys[row1] < keys[row2]; });
+    else
+        merge_sort(m_row_mappings, [&] (int row1, int row2) { return keys[row2] < keys[row1]; });
+
     if (previously_selected_target_row != -1) {
         // Preserve selection.
         for (int i = 0; i < row_count; ++i) {
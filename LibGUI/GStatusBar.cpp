@@ -17,6 +17,7 @@ GStatusBar::GStatusBar(GWidget* parent)
     m_label->set_frame_shape(GFrame::Shape::Panel);
     m_label->set_frame_thickness(1);
     m_label->set_text_alignment(TextAlignment::CenterLeft);
+    set_paint_cache_enabled(true);
 }
 
 GStatusBar::~GStatusBar()
@@ -84,12 +84,11 @@ void GTableView::mousedown_event(GMouseEvent& event)
 
     if (event.button() == GMouseButton::Left) {
         auto adjusted_position = event.position().translated(0, vertical_scrollbar().value());
-        for (int i = 0; i < item_count(); ++i) {
-            if (row_rect(i).contains(adjusted_position)) {
-                model()->set_selected_index(model()->index(i, 0));
-                update();
-                return;
-            }
+        int row_index = (adjusted_position.y() - header_height()) / item_height();
+        if (row_index >= 0 && row_index < item_count() && row_rect(row_index).contains(adjusted_position)) {
+            model()->set_selected_index(model()->index(row_index, 0));
+            update();
+            return;
         }
         model()->set_selected_index({ });
         update();
@@ -107,12 +106,39 @@ void GTableView::paint_event(GPaintEvent& event)
     painter.translate(-horizontal_scrollbar().value(), -vertical_scrollbar().value());
 
     int exposed_width = max(content_size().width(), width());
-    int painted_item_index = 0;
     int y_offset = header_height();
+    int row_count = model()->row_count();
+    int column_count = model()->column_count();
+    int key_column = model()->key_column();
+    int selected_row = model()->selected_index().row();
+
+    // Only rows and columns that intersect the paint rect are fetched from the model.
+    auto paint_rect = Rect::intersection(frame_inner_rect(), event.rect());
+    paint_rect.move_by(horizontal_scrollbar().value(), vertical_scrollbar().value());
+
+    int first_visible_row = max(0, (paint_rect.top() - y_offset) / item_height());
+    int last_visible_row = min(row_count - 1, (paint_rect.bottom() - y_offset) / item_height());
+
+    struct VisibleColumn {
+        int index;
+        int x_offset;
+        GModel::ColumnMetadata metadata;
+    };
+    Vector<VisibleColumn> visible_columns;
+    int x_offset = 0;
+    for (int column_index = 0; column_index < column_count; ++column_index) {
+        if (is_column_hidden(column_index))
+            continue;
+        auto column_metadata = model()->column_metadata(column_index);
+        int column_rect_width = column_metadata.preferred_width + horizontal_padding() * 2;
+        if (x_offset <= paint_rect.right() && x_offset + column_rect_width > paint_rect.left())
+            visible_columns.append({ column_index, x_offset, column_metadata });
+        x_offset += column_rect_width;
+    }
 
-    for (int row_index = 0; row_index < model()->row_count(); ++row_index) {
-        bool is_selected_row = row_index == model()->selected_index().row();
-        int y = y_offset + painted_item_index * item_height();
+    for (int row_index = first_visible_row; row_index <= last_visible_row; ++row_index) {
+        bool is_selected_row = row_index == selected_row;
+        int y = y_offset + row_index * item_height();
 
         Color background_color;
         Color key_column_background_color;
@@ -120,7 +146,7 @@ void GTableView::paint_event(GPaintEvent& event)
             background_color = is_focused() ? Color::from_rgb(0x84351a) : Color::from_rgb(0x606060);
             key_column_background_color = is_focused() ? Color::from_rgb(0x84351a) : Color::from_rgb(0x606060);
         } else {
-            if (alternating_row_colors() && (painted_item_index % 2)) {
+            if (alternating_row_colors() && (row_index % 2)) {
                 background_color = Color(210, 210, 210);
                 key_column_background_color = Color(190, 190, 190);
             } else {
@@ -128,22 +154,19 @@ void GTableView::paint_event(GPaintEvent& event)
                 key_column_background_color = Color(235, 235, 235);
             }
         }
-        painter.fill_rect(row_rect(painted_item_index), background_color);
+        painter.fill_rect(row_rect(row_index), background_color);
 
-        int x_offset = 0;
-        for (int column_index = 0; column_index < model()->column_count(); ++column_index) {
-            if (is_column_hidden(column_index))
-                continue;
-            auto column_metadata = model()->column_metadata(column_index);
+        for (auto& column : visible_columns) {
+            auto& column_metadata = column.metadata;
             int column_width = column_metadata.preferred_width;
             const Font& font = column_metadata.font ? *column_metadata.font : this->font();
-            bool is_key_column = model()->key_column() == column_index;
-            Rect cell_rect(horizontal_padding() + x_offset, y, column_width, item_height());
+            bool is_key_column = key_column == column.index;
+            Rect cell_rect(horizontal_padding() + column.x_offset, y, column_width, item_height());
             if (is_key_column) {
                 auto cell_rect_for_fill = cell_rect.inflated(horizontal_padding() * 2, 0);
                 painter.fill_rect(cell_rect_for_fill, key_column_background_color);
             }
-            auto cell_index = model()->index(row_index, column_index);
+            auto cell_index = model()->index(row_index, column.index);
             auto data = model()->data(cell_index);
             if (data.is_bitmap()) {
                 painter.blit(cell_rect.location(), data.as_bitmap(), data.as_bitmap().rect());
@@ -156,14 +179,15 @@ void GTableView::paint_event(GPaintEvent& event)
                     text_color = Color::White;
                 else
                     text_color = model()->data(cell_index, GModel::Role::ForegroundColor).to_color(Color::Black);
-                painter.draw_text(cell_rect, data.to_string(), font, column_metadata.text_alignment, text_color);
+                GVariant::TextBuffer text_buffer;
+                int text_length;
+                auto* text = data.to_text(text_buffer, text_length);
+                painter.draw_text(cell_rect, text, text_length, font, column_metadata.text_alignment, text_color);
             }
-            x_offset += column_width + horizontal_padding() * 2;
         }
-        ++painted_item_index;
     };
 
-    Rect unpainted_rect(0, header_height() + painted_item_index * item_height(), exposed_width, height());
+    Rect unpainted_rect(0, header_height() + row_count * item_height(), exposed_width, height());
     painter.fill_rect(unpainted_rect, Color::White);
 
     // Untranslate the painter vertically and do the column headers.
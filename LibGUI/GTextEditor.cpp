@@ -6,6 +6,7 @@
 #include <LibGUI/GWindow.h>
 #include <Kernel/KeyCode.h>
 #include <AK/StringBuilder.h>
+#include <sys/stat.h>
 #include <unistd.h>
 #include <fcntl.h>
 #include <stdio.h>
@@ -32,24 +33,37 @@ void GTextEditor::set_text(const String& text)
 {
     if (is_single_line() && text.length() == m_lines[0]->length() && !memcmp(text.characters(), m_lines[0]->characters(), text.length()))
         return;
+    set_text(text.characters(), text.length());
+}
+
+void GTextEditor::set_text(const char* characters, int length)
+{
+    build_lines(characters, length, false);
+    // Nothing references the previous file's mapping any more.
+    m_mapped_file.unmap();
+}
+
+void GTextEditor::build_lines(const char* characters, int length, bool reference_characters)
+{
+    int newline_count = 0;
+    for (int i = 0; i < length; ++i) {
+        if (characters[i] == '\n')
+            ++newline_count;
+    }
 
     m_lines.clear();
+    m_lines.ensure_capacity(newline_count + 1);
     int start_of_current_line = 0;
-
-    auto add_line = [&] (int current_position) {
-        int line_length = current_position - start_of_current_line;
-        auto line = make<Line>();
-        if (line_length)
-            line->set_text(text.substring(start_of_current_line, current_position - start_of_current_line));
-        m_lines.append(move(line));
-        start_of_current_line = current_position + 1;
-    };
-    int i = 0;
-    for (i = 0; i < text.length(); ++i) {
-        if (text[i] == '\n')
-            add_line(i);
+    for (int i = 0; i <= length; ++i) {
+        if (i != length && characters[i] != '\n')
+            continue;
+        if (reference_characters)
+            m_lines.append(make<Line>(Line::Reference, characters + start_of_current_line, i - start_of_current_line));
+        else
+            m_lines.append(make<Line>(characters + start_of_current_line, i - start_of_current_line));
+        start_of_current_line = i + 1;
     }
-    add_line(i);
+    m_selection.clear();
     update_content_size();
     if (is_single_line())
         set_cursor(0, m_lines[0]->length());
@@ -58,12 +72,68 @@ void GTextEditor::set_text(const String& text)
     update();
 }
 
+bool GTextEditor::read_from_file(const String& path)
+{
+    struct stat st;
+    if (stat(path.characters(), &st) < 0) {
+        perror("stat");
+        return false;
+    }
+    if (st.st_size) {
+        // Have the lines point straight into a mapping of the file, so that opening even a very large file
+        // only costs one scan for newlines. A line gets its own copy of its text once it's modified.
+        MappedFile mapped_file(path);
+        if (mapped_file.is_valid()) {
+            auto* characters = (const char*)mapped_file.pointer();
+            int length = mapped_file.size();
+            m_lines.clear();
+            m_mapped_file = move(mapped_file);
+            build_lines(characters, length, true);
+            return true;
+        }
+    }
+
+    // Files that can't be mapped, and files that report a size of 0 but still have contents
+    // (like the ones in /proc), are read into a buffer instead.
+    int fd = open(path.characters(), O_RDONLY);
+    if (fd < 0) {
+        perror("open");
+        return false;
+    }
+    Vector<char> buffer;
+    for (;;) {
+        int old_size = buffer.size();
+        buffer.resize(old_size + 4096);
+        ssize_t nread = read(fd, buffer.data() + old_size, 4096);
+        if (nread < 0) {
+            perror("read");
+            close(fd);
+            return false;
+        }
+        buffer.resize(old_size + nread);
+        if (nread == 0)
+            break;
+    }
+    close(fd);
+    set_text(buffer.data(), buffer.size());
+    return true;
+}
+
+void GTextEditor::detach_lines_from_mapped_file()
+{
+    if (!m_mapped_file.is_valid())
+        return;
+    for (auto& line : m_lines)
+        line->detach();
+    m_mapped_file.unmap();
+}
+
 void GTextEditor::update_content_size()
 {
-    int content_width = 0;
+    int longest_line_length = 0;
     for (auto& line : m_lines)
-        content_width = max(line->width(font()), content_width);
-    content_width += m_horizontal_content_padding * 2;
+        longest_line_length = max(line->length(), longest_line_length);
+    int content_width = longest_line_length * glyph_width() + m_horizontal_content_padding * 2;
     int content_height = line_count() * line_height();
     set_content_size({ content_width, content_height });
     set_size_occupied_by_fixed_elements({ ruler_width(), 0 });
@@ -93,6 +163,7 @@ void GTextEditor::mousedown_event(GMouseEvent& event)
 
         m_in_drag_select = true;
 
+        auto old_selection = normalized_selection();
         set_cursor(text_position_at(event.position()));
 
         if (!(event.modifiers() & Mod_Shift)) {
@@ -103,8 +174,10 @@ void GTextEditor::mousedown_event(GMouseEvent& event)
         if (m_selection.start().is_valid())
             m_selection.set_end(m_cursor);
 
-        // FIXME: Only update the relevant rects.
-        update();
+        if (old_selection.is_valid())
+            update_lines(old_selection.start().line(), old_selection.end().line());
+        if (has_selection())
+            update_lines(normalized_selection().start().line(), normalized_selection().end().line());
         return;
     }
 }
@@ -122,9 +195,7 @@ void GTextEditor::mouseup_event(GMouseEvent& event)
 void GTextEditor::mousemove_event(GMouseEvent& event)
 {
     if (m_in_drag_select) {
-        set_cursor(text_position_at(event.position()));
-        m_selection.set_end(m_cursor);
-        update();
+        move_cursor_and_update(text_position_at(event.position()), true);
         return;
     }
 }
@@ -180,9 +251,12 @@ void GTextEditor::paint_event(GPaintEvent& event)
         for (int i = first_visible_line; i <= last_visible_line; ++i) {
             bool is_current_line = i == m_cursor.line();
             auto ruler_line_rect = ruler_content_rect(i);
+            char line_number[16];
+            int line_number_length = sprintf(line_number, "%u", i);
             painter.draw_text(
                 ruler_line_rect.shrunken(2, 0),
-                String::format("%u", i),
+                line_number,
+                line_number_length,
                 is_current_line ? Font::default_bold_font() : font(),
                 TextAlignment::CenterRight,
                 is_current_line ? Color::DarkGray : Color::MidGray
@@ -215,20 +289,6 @@ void GTextEditor::paint_event(GPaintEvent& event)
         painter.fill_rect(cursor_content_rect(), Color::Red);
 }
 
-void GTextEditor::toggle_selection_if_needed_for_event(const GKeyEvent& event)
-{
-    if (event.shift() && !m_selection.is_valid()) {
-        m_selection.set(m_cursor, { });
-        update();
-        return;
-    }
-    if (!event.shift() && m_selection.is_valid()) {
-        m_selection.clear();
-        update();
-        return;
-    }
-}
-
 void GTextEditor::keydown_event(GKeyEvent& event)
 {
     if (event.key() == KeyCode::Key_Escape) {
@@ -240,10 +300,7 @@ void GTextEditor::keydown_event(GKeyEvent& event)
         if (m_cursor.line() > 0) {
             int new_line = m_cursor.line() - 1;
             int new_column = min(m_cursor.column(), m_lines[new_line]->length());
-            toggle_selection_if_needed_for_event(event);
-            set_cursor(new_line, new_column);
-            if (m_selection.start().is_valid())
-                m_selection.set_end(m_cursor);
+            move_cursor_and_update({ new_line, new_column }, event.shift());
         }
         return;
     }
@@ -251,10 +308,7 @@ void GTextEditor::keydown_event(GKeyEvent& event)
         if (m_cursor.line() < (m_lines.size() - 1)) {
             int new_line = m_cursor.line() + 1;
             int new_column = min(m_cursor.column(), m_lines[new_line]->length());
-            toggle_selection_if_needed_for_event(event);
-            set_cursor(new_line, new_column);
-            if (m_selection.start().is_valid())
-                m_selection.set_end(m_cursor);
+            move_cursor_and_update({ new_line, new_column }, event.shift());
         }
         return;
     }
@@ -262,10 +316,7 @@ void GTextEditor::keydown_event(GKeyEvent& event)
         if (m_cursor.line() > 0) {
             int new_line = max(0, m_cursor.line() - visible_content_rect().height() / line_height());
             int new_column = min(m_cursor.column(), m_lines[new_line]->length());
-            toggle_selection_if_needed_for_event(event);
-            set_cursor(new_line, new_column);
-            if (m_selection.start().is_valid())
-                m_selection.set_end(m_cursor);
+            move_cursor_and_update({ new_line, new_column }, event.shift());
         }
         return;
     }
@@ -273,73 +324,46 @@ void GTextEditor::keydown_event(GKeyEvent& event)
         if (m_cursor.line() < (m_lines.size() - 1)) {
             int new_line = min(line_count() - 1, m_cursor.line() + visible_content_rect().height() / line_height());
             int new_column = min(m_cursor.column(), m_lines[new_line]->length());
-            toggle_selection_if_needed_for_event(event);
-            set_cursor(new_line, new_column);
-            if (m_selection.start().is_valid())
-                m_selection.set_end(m_cursor);
+            move_cursor_and_update({ new_line, new_column }, event.shift());
         }
         return;
     }
     if (event.key() == KeyCode::Key_Left) {
         if (m_cursor.column() > 0) {
             int new_column = m_cursor.column() - 1;
-            toggle_selection_if_needed_for_event(event);
-            set_cursor(m_cursor.line(), new_column);
-            if (m_selection.start().is_valid())
-                m_selection.set_end(m_cursor);
+            move_cursor_and_update({ m_cursor.line(), new_column }, event.shift());
         } else if (m_cursor.line() > 0) {
             int new_line = m_cursor.line() - 1;
             int new_column = m_lines[new_line]->length();
-            toggle_selection_if_needed_for_event(event);
-            set_cursor(new_line, new_column);
-            if (m_selection.start().is_valid())
-                m_selection.set_end(m_cursor);
+            move_cursor_and_update({ new_line, new_column }, event.shift());
         }
         return;
     }
     if (event.key() == KeyCode::Key_Right) {
         if (m_cursor.column() < current_line().length()) {
             int new_column = m_cursor.column() + 1;
-            toggle_selection_if_needed_for_event(event);
-            set_cursor(m_cursor.line(), new_column);
-            if (m_selection.start().is_valid())
-                m_selection.set_end(m_cursor);
+            move_cursor_and_update({ m_cursor.line(), new_column }, event.shift());
         } else if (m_cursor.line() != line_count() - 1) {
             int new_line = m_cursor.line() + 1;
             int new_column = 0;
-            toggle_selection_if_needed_for_event(event);
-            set_cursor(new_line, new_column);
-            if (m_selection.start().is_valid())
-                m_selection.set_end(m_cursor);
+            move_cursor_and_update({ new_line, new_column }, event.shift());
         }
         return;
     }
     if (!event.ctrl() && event.key() == KeyCode::Key_Home) {
-        toggle_selection_if_needed_for_event(event);
-        set_cursor(m_cursor.line(), 0);
-        if (m_selection.start().is_valid())
-            m_selection.set_end(m_cursor);
+        move_cursor_and_update({ m_cursor.line(), 0 }, event.shift());
         return;
     }
     if (!event.ctrl() && event.key() == KeyCode::Key_End) {
-        toggle_selection_if_needed_for_event(event);
-        set_cursor(m_cursor.line(), current_line().length());
-        if (m_selection.start().is_valid())
-            m_selection.set_end(m_cursor);
+        move_cursor_and_update({ m_cursor.line(), current_line().length() }, event.shift());
         return;
     }
     if (event.ctrl() && event.key() == KeyCode::Key_Home) {
-        toggle_selection_if_needed_for_event(event);
-        set_cursor(0, 0);
-        if (m_selection.start().is_valid())
-            m_selection.set_end(m_cursor);
+        move_cursor_and_update({ 0, 0 }, event.shift());
         return;
     }
     if (event.ctrl() && event.key() == KeyCode::Key_End) {
-        toggle_selection_if_needed_for_event(event);
-        set_cursor(line_count() - 1, m_lines[line_count() - 1]->length());
-        if (m_selection.start().is_valid())
-            m_selection.set_end(m_cursor);
+        move_cursor_and_update({ line_count() - 1, m_lines[line_count() - 1]->length() }, event.shift());
         return;
     }
     if (event.modifiers() == Mod_Ctrl && event.key() == KeyCode::Key_A) {
@@ -370,7 +394,7 @@ void GTextEditor::keydown_event(GKeyEvent& event)
             previous_line.append(current_line().characters(), current_line().length());
             m_lines.remove(m_cursor.line());
             update_content_size();
-            update();
+            update_lines_from(m_cursor.line() - 1);
             set_cursor(m_cursor.line() - 1, previous_length);
             return;
         }
@@ -403,7 +427,11 @@ void GTextEditor::delete_current_line()
         m_lines.append(make<Line>());
 
     update_content_size();
-    update();
+    update_lines_from(m_cursor.line());
+    if (m_cursor.line() >= line_count())
+        set_cursor(line_count() - 1, 0);
+    else if (m_cursor.column() > current_line().length())
+        set_cursor(m_cursor.line(), current_line().length());
 }
 
 void GTextEditor::do_delete()
@@ -425,7 +453,7 @@ void GTextEditor::do_delete()
         current_line().append(next_line.characters(), next_line.length());
         m_lines.remove(m_cursor.line() + 1);
         update_content_size();
-        update();
+        update_lines_from(m_cursor.line());
         set_cursor(m_cursor.line(), previous_length);
         return;
     }
@@ -433,10 +461,56 @@ void GTextEditor::do_delete()
 
 void GTextEditor::insert_at_cursor(const String& text)
 {
-    // FIXME: This should obviously not be implemented this way.
+    if (is_single_line() || text.length() <= 1) {
+        for (int i = 0; i < text.length(); ++i)
+            insert_at_cursor(text[i]);
+        return;
+    }
+
+    // Build the inserted lines on the side and splice them in at once, so pasting a large
+    // block costs one pass over the document instead of one per character.
+    auto& line = current_line();
+    int cursor_column = m_cursor.column();
+    String tail(line.characters() + cursor_column, line.length() - cursor_column);
+    line.truncate(cursor_column);
+
+    Vector<OwnPtr<Line>> new_lines;
+    Line* target_line = &line;
     for (int i = 0; i < text.length(); ++i) {
-        insert_at_cursor(text[i]);
+        char ch = text[i];
+        if (ch == '\n') {
+            new_lines.append(make<Line>());
+            target_line = new_lines.last().ptr();
+            continue;
+        }
+        if (ch == '\t') {
+            int column = target_line->length();
+            int next_soft_tab_stop = ((column + m_soft_tab_width) / m_soft_tab_width) * m_soft_tab_width;
+            for (int j = column; j < next_soft_tab_stop; ++j)
+                target_line->append(' ');
+            continue;
+        }
+        target_line->append(ch);
     }
+    int new_cursor_column = target_line->length();
+    target_line->append(tail.characters(), tail.length());
+
+    int new_cursor_line = m_cursor.line() + new_lines.size();
+    if (!new_lines.is_empty()) {
+        Vector<OwnPtr<Line>> lines;
+        lines.ensure_capacity(m_lines.size() + new_lines.size());
+        for (int i = 0; i <= m_cursor.line(); ++i)
+            lines.unchecked_append(move(m_lines[i]));
+        for (auto& new_line : new_lines)
+            lines.unchecked_append(move(new_line));
+        for (int i = m_cursor.line() + 1; i < m_lines.size(); ++i)
+            lines.unchecked_append(move(m_lines[i]));
+        m_lines = move(lines);
+    }
+
+    update_content_size();
+    update_lines_from(m_cursor.line());
+    set_cursor(new_cursor_line, new_cursor_column);
 }
 
 void GTextEditor::insert_at_cursor(char ch)
@@ -452,7 +526,7 @@ void GTextEditor::insert_at_cursor(char ch)
         if (at_tail || at_head) {
             m_lines.insert(m_cursor.line() + (at_tail ? 1 : 0), make<Line>());
             update_content_size();
-            update();
+            update_lines_from(m_cursor.line());
             set_cursor(m_cursor.line() + 1, 0);
             return;
         }
@@ -461,7 +535,7 @@ void GTextEditor::insert_at_cursor(char ch)
         current_line().truncate(m_cursor.column());
         m_lines.insert(m_cursor.line() + 1, move(new_line));
         update_content_size();
-        update();
+        update_lines_from(m_cursor.line());
         set_cursor(m_cursor.line() + 1, 0);
         return;
     }
@@ -536,11 +610,62 @@ Rect GTextEditor::line_content_rect(int line_index) const
     };
 }
 
+Rect GTextEditor::cursor_widget_rect() const
+{
+    auto rect = cursor_content_rect();
+    rect.move_by(ruler_width() - horizontal_scrollbar().value(), -vertical_scrollbar().value());
+    return rect.inflated(2, 0);
+}
+
 void GTextEditor::update_cursor()
 {
     update(line_widget_rect(m_cursor.line()));
 }
 
+void GTextEditor::update_lines(int first_line, int last_line)
+{
+    if (is_single_line()) {
+        update();
+        return;
+    }
+    int top = first_line * line_height() - vertical_scrollbar().value();
+    int bottom = (last_line + 1) * line_height() - vertical_scrollbar().value();
+    auto rect = Rect::intersection({ 0, top, width(), bottom - top }, frame_inner_rect());
+    if (!rect.is_empty())
+        update(rect);
+}
+
+void GTextEditor::move_cursor_and_update(const GTextPosition& position, bool extend_selection)
+{
+    if (extend_selection && !m_selection.is_valid()) {
+        // Nothing is selected until the cursor moves; the lines it moves across are repainted below.
+        m_selection.set(m_cursor, { });
+    } else if (!extend_selection && m_selection.is_valid()) {
+        auto selection = normalized_selection();
+        m_selection.clear();
+        update_lines(selection.start().line(), selection.end().line());
+    }
+    int old_cursor_line = m_cursor.line();
+    set_cursor(position);
+    if (extend_selection) {
+        m_selection.set_end(m_cursor);
+        update_lines(min(old_cursor_line, m_cursor.line()), max(old_cursor_line, m_cursor.line()));
+    }
+}
+
+void GTextEditor::update_lines_from(int line_index)
+{
+    if (is_single_line()) {
+        update();
+        return;
+    }
+    // Everything below this line moved, including the space where removed lines used to be.
+    int top = line_index * line_height() - vertical_scrollbar().value();
+    auto rect = Rect::intersection({ 0, top, width(), height() - top }, frame_inner_rect());
+    if (!rect.is_empty())
+        update(rect);
+}
+
 void GTextEditor::set_cursor(int line, int column)
 {
     set_cursor({ line, column });
@@ -578,7 +703,7 @@ void GTextEditor::timer_event(GTimerEvent&)
 {
     m_cursor_state = !m_cursor_state;
     if (is_focused())
-        update_cursor();
+        update(cursor_widget_rect());
 }
 
 GTextEditor::Line::Line()
@@ -586,8 +711,36 @@ GTextEditor::Line::Line()
     clear();
 }
 
+GTextEditor::Line::Line(const char* characters, int length)
+{
+    m_text.resize(length + 1);
+    memcpy(m_text.data(), characters, length);
+    m_text.last() = 0;
+}
+
+GTextEditor::Line::Line(ReferenceTag, const char* characters, int length)
+    : m_referenced_characters(characters)
+    , m_referenced_length(length)
+{
+}
+
+void GTextEditor::Line::detach()
+{
+    if (!m_referenced_characters)
+        return;
+    const char* characters = m_referenced_characters;
+    int length = m_referenced_length;
+    m_referenced_characters = nullptr;
+    m_referenced_length = 0;
+    m_text.resize(length + 1);
+    memcpy(m_text.data(), characters, length);
+    m_text.last() = 0;
+}
+
 void GTextEditor::Line::clear()
 {
+    m_referenced_characters = nullptr;
+    m_referenced_length = 0;
     m_text.clear();
     m_text.append(0);
 }
@@ -600,6 +753,8 @@ void GTextEditor::Line::set_text(const String& text)
         clear();
         return;
     }
+    m_referenced_characters = nullptr;
+    m_referenced_length = 0;
     m_text.resize(text.length() + 1);
     memcpy(m_text.data(), text.characters(), text.length() + 1);
 }
@@ -611,6 +766,7 @@ int GTextEditor::Line::width(const Font& font) const
 
 void GTextEditor::Line::append(const char* characters, int length)
 {
+    detach();
     int old_length = m_text.size() - 1;
     m_text.resize(m_text.size() + length);
     memcpy(m_text.data() + old_length, characters, length);
@@ -629,6 +785,7 @@ void GTextEditor::Line::prepend(char ch)
 
 void GTextEditor::Line::insert(int index, char ch)
 {
+    detach();
     if (index == length()) {
         m_text.last() = ch;
         m_text.append(0);
@@ -639,6 +796,7 @@ void GTextEditor::Line::insert(int index, char ch)
 
 void GTextEditor::Line::remove(int index)
 {
+    detach();
     if (index == length()) {
         m_text.take_last();
         m_text.last() = 0;
@@ -649,36 +807,67 @@ void GTextEditor::Line::remove(int index)
 
 void GTextEditor::Line::truncate(int length)
 {
+    if (m_referenced_characters) {
+        m_referenced_length = length;
+        return;
+    }
     m_text.resize(length + 1);
     m_text.last() = 0;
 }
 
 bool GTextEditor::write_to_file(const String& path)
 {
+    // We may be about to truncate the very file that the lines point into.
+    detach_lines_from_mapped_file();
+
     int fd = open(path.characters(), O_WRONLY | O_CREAT | O_TRUNC, 0666);
     if (fd < 0) {
         perror("open");
         return false;
     }
-    for (int i = 0; i < m_lines.size(); ++i) {
-        auto& line = *m_lines[i];
-        if (line.length()) {
-            ssize_t nwritten = write(fd, line.characters(), line.length());
+
+    // Gather lines into a buffer and write it out in large chunks instead of two writes per line.
+    static const int buffer_size = 64 * KB;
+    Vector<char> buffer;
+    buffer.ensure_capacity(buffer_size);
+    auto flush_buffer = [&] {
+        int offset = 0;
+        while (offset < buffer.size()) {
+            ssize_t nwritten = write(fd, buffer.data() + offset, buffer.size() - offset);
             if (nwritten < 0) {
                 perror("write");
-                close(fd);
                 return false;
             }
+            offset += nwritten;
+        }
+        buffer.clear_with_capacity();
+        return true;
+    };
+
+    for (int i = 0; i < m_lines.size(); ++i) {
+        auto& line = *m_lines[i];
+        bool needs_newline = i != m_lines.size() - 1;
+        if (buffer.size() + line.length() + 1 > buffer_size && !flush_buffer()) {
+            close(fd);
+            return false;
         }
-        if (i != m_lines.size() - 1) {
-            char ch = '\n';
-            ssize_t nwritten = write(fd, &ch, 1);
-            if (nwritten != 1) {
+        if (line.length() > buffer_size) {
+            // Too long to be worth buffering; the buffer was just flushed, so write it directly.
+            ssize_t nwritten = write(fd, line.characters(), line.length());
+            if (nwritten != line.length()) {
                 perror("write");
                 close(fd);
                 return false;
             }
+        } else {
+            buffer.append(line.characters(), line.length());
         }
+        if (needs_newline)
+            buffer.append('\n');
+    }
+    if (!flush_buffer()) {
+        close(fd);
+        return false;
     }
 
     close(fd);
@@ -687,7 +876,10 @@ bool GTextEditor::write_to_file(const String& path)
 
 String GTextEditor::text() const
 {
-    StringBuilder builder;
+    int length = 0;
+    for (auto& line : m_lines)
+        length += line->length() + 1;
+    StringBuilder builder(length);
     for (int i = 0; i < line_count(); ++i) {
         auto& line = *m_lines[i];
         builder.append(line.characters(), line.length());
@@ -701,6 +893,7 @@ void GTextEditor::clear()
 {
     m_lines.clear();
     m_lines.append(make<Line>());
+    m_mapped_file.unmap();
     m_selection.clear();
     set_cursor(0, 0);
     update();
@@ -771,7 +964,7 @@ void GTextEditor::delete_selection()
 
     m_selection.clear();
     set_cursor(selection.start());
-    update();
+    update_lines_from(selection.start().line());
 }
 
 void GTextEditor::insert_at_cursor_or_replace_selection(const String& text)
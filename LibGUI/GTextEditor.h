@@ -3,6 +3,7 @@
 #include <LibGUI/GScrollableWidget.h>
 #include <AK/Function.h>
 #include <AK/HashMap.h>
+#include <AK/MappedFile.h>
 
 class GScrollBar;
 class Painter;
@@ -82,6 +83,7 @@ public:
     GTextRange normalized_selection() const { return m_selection.normalized(); }
     int glyph_width() const { return font().glyph_width('x'); }
 
+    bool read_from_file(const String& path);
     bool write_to_file(const String& path);
 
     bool has_selection() const { return m_selection.is_valid(); }
@@ -114,6 +116,9 @@ private:
     virtual void enter_event(GEvent&) override;
     virtual void leave_event(GEvent&) override;
 
+    void set_text(const char*, int length);
+    void build_lines(const char*, int length, bool reference_characters);
+    void detach_lines_from_mapped_file();
     void paint_ruler(Painter&);
     void update_content_size();
 
@@ -121,9 +126,15 @@ private:
         friend class GTextEditor;
     public:
         Line();
+        Line(const char* characters, int length);
 
-        const char* characters() const { return m_text.data(); }
-        int length() const { return m_text.size() - 1; }
+        // A line that keeps pointing at 'characters' (in the editor's mapped file) until it's first modified.
+        enum ReferenceTag { Reference };
+        Line(ReferenceTag, const char* characters, int length);
+
+        const char* characters() const { return m_referenced_characters ? m_referenced_characters : m_text.data(); }
+        int length() const { return m_referenced_characters ? m_referenced_length : m_text.size() - 1; }
+        void detach();
         int width(const Font&) const;
         void set_text(const String&);
         void append(char);
@@ -135,14 +146,21 @@ private:
         void clear();
 
     private:
-        // NOTE: This vector is null terminated.
+        // NOTE: This vector is null terminated, unless the line is referencing.
         Vector<char> m_text;
+        const char* m_referenced_characters { nullptr };
+        int m_referenced_length { 0 };
     };
 
     Rect line_content_rect(int item_index) const;
     Rect line_widget_rect(int line_index) const;
     Rect cursor_content_rect() const;
+    Rect cursor_widget_rect() const;
     void update_cursor();
+    void update_lines(int first_line, int last_line);
+    void update_lines_from(int line_index);
+    // Moves the cursor, and either extends the selection to it or clears the selection, repainting whatever changed.
+    void move_cursor_and_update(const GTextPosition&, bool extend_selection);
     void set_cursor(int line, int column);
     void set_cursor(const GTextPosition&);
     Line& current_line() { return *m_lines[m_cursor.line()]; }
@@ -152,13 +170,14 @@ private:
     void insert_at_cursor(const String&);
     int ruler_width() const;
     Rect ruler_content_rect(int line) const;
-    void toggle_selection_if_needed_for_event(const GKeyEvent&);
     void insert_at_cursor_or_replace_selection(const String&);
     void delete_selection();
 
     Type m_type { MultiLine };
 
     Vector<OwnPtr<Line>> m_lines;
+    // The file from read_from_file(), as long as any line still references it.
+    MappedFile m_mapped_file;
     GTextPosition m_cursor;
     bool m_cursor_state { true };
     bool m_in_drag_select { false };
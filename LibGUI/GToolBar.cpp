@@ -12,6 +12,7 @@ GToolBar::GToolBar(GWidget* parent)
     set_layout(make<GBoxLayout>(Orientation::Horizontal));
     layout()->set_spacing(0);
     layout()->set_margins({ 2, 2, 2, 2 });
+    set_paint_cache_enabled(true);
 }
 
 GToolBar::~GToolBar()
@@ -1,14 +1,21 @@
 #include <LibGUI/GVariant.h>
+#include <stdio.h>
+#include <string.h>
 
 GVariant::GVariant()
 {
 }
 
 GVariant::~GVariant()
+{
+    clear();
+}
+
+void GVariant::clear()
 {
     switch (m_type) {
     case Type::String:
-        if (m_value.as_string)
+        if (!m_string_is_inline && m_value.as_string)
             m_value.as_string->release();
         break;
     case Type::Bitmap:
@@ -22,6 +29,71 @@ GVariant::~GVariant()
     default:
         break;
     }
+    m_type = Type::Invalid;
+    m_string_is_inline = false;
+}
+
+void GVariant::copy_from(const GVariant& other)
+{
+    ASSERT(!is_valid());
+    m_type = other.m_type;
+    m_string_is_inline = other.m_string_is_inline;
+    m_inline_string_length = other.m_inline_string_length;
+    m_value = other.m_value;
+    switch (m_type) {
+    case Type::String:
+        if (!m_string_is_inline)
+            AK::retain_if_not_null(m_value.as_string);
+        break;
+    case Type::Bitmap:
+        AK::retain_if_not_null(m_value.as_bitmap);
+        break;
+    case Type::Icon:
+        AK::retain_if_not_null(m_value.as_icon);
+        break;
+    default:
+        break;
+    }
+}
+
+void GVariant::move_from(GVariant&& other)
+{
+    ASSERT(!is_valid());
+    m_type = other.m_type;
+    m_string_is_inline = other.m_string_is_inline;
+    m_inline_string_length = other.m_inline_string_length;
+    m_value = other.m_value;
+    // We've taken over other's reference, if it had one.
+    other.m_type = Type::Invalid;
+    other.m_string_is_inline = false;
+}
+
+GVariant::GVariant(const GVariant& other)
+{
+    copy_from(other);
+}
+
+GVariant::GVariant(GVariant&& other)
+{
+    move_from(move(other));
+}
+
+GVariant& GVariant::operator=(const GVariant& other)
+{
+    if (this != &other) {
+        clear();
+        copy_from(other);
+    }
+    return *this;
+}
+
+GVariant& GVariant::operator=(GVariant&& other)
+{
+    if (this != &other) {
+        clear();
+        move_from(move(other));
+    }
+    return *this;
 }
 
 GVariant::GVariant(int value)
@@ -49,6 +121,24 @@ GVariant::GVariant(const String& value)
     AK::retain_if_not_null(m_value.as_string);
 }
 
+GVariant::GVariant(const char* characters)
+    : GVariant(characters, characters ? strlen(characters) : 0)
+{
+}
+
+GVariant::GVariant(const char* characters, int length)
+    : m_type(Type::String)
+{
+    if (length > inline_string_capacity) {
+        m_value.as_string = StringImpl::create(characters, length).leak_ref();
+        return;
+    }
+    m_string_is_inline = true;
+    m_inline_string_length = length;
+    memcpy(m_value.as_inline_string, characters, length);
+    m_value.as_inline_string[length] = '\0';
+}
+
 GVariant::GVariant(const GraphicsBitmap& value)
     : m_type(Type::Bitmap)
 {
@@ -80,8 +170,13 @@ bool GVariant::operator==(const GVariant& other) const
         return as_int() == other.as_int();
     case Type::Float:
         return as_float() == other.as_float();
-    case Type::String:
-        return as_string() == other.as_string();
+    case Type::String: {
+        auto* characters = string_characters();
+        auto* other_characters = other.string_characters();
+        if (!characters || !other_characters)
+            return characters == other_characters;
+        return string_length() == other.string_length() && !memcmp(characters, other_characters, string_length());
+    }
     case Type::Bitmap:
         return m_value.as_bitmap == other.m_value.as_bitmap;
     case Type::Icon:
@@ -105,8 +200,13 @@ bool GVariant::operator<(const GVariant& other) const
         return as_int() < other.as_int();
     case Type::Float:
         return as_float() < other.as_float();
-    case Type::String:
-        return as_string() < other.as_string();
+    case Type::String: {
+        auto* characters = string_characters();
+        auto* other_characters = other.string_characters();
+        if (!characters || !other_characters)
+            return !characters && other_characters;
+        return strcmp(characters, other_characters) < 0;
+    }
     case Type::Bitmap:
         // FIXME: Maybe compare bitmaps somehow differently?
         return m_value.as_bitmap < other.m_value.as_bitmap;
@@ -144,3 +244,39 @@ String GVariant::to_string() const
     ASSERT_NOT_REACHED();
 }
 
+
+const char* GVariant::to_text(TextBuffer& buffer, int& length) const
+{
+    switch (m_type) {
+    case Type::String: {
+        length = string_length();
+        auto* characters = string_characters();
+        return characters ? characters : "";
+    }
+    case Type::Bool: {
+        auto* text = as_bool() ? "True" : "False";
+        length = strlen(text);
+        return text;
+    }
+    case Type::Int:
+        length = snprintf(buffer.characters, sizeof(buffer.characters), "%d", as_int());
+        return buffer.characters;
+    case Type::Float:
+        length = snprintf(buffer.characters, sizeof(buffer.characters), "%f", (double)as_float());
+        return buffer.characters;
+    case Type::Bitmap:
+        length = strlen("[GraphicsBitmap]");
+        return "[GraphicsBitmap]";
+    case Type::Icon:
+        length = strlen("[GIcon]");
+        return "[GIcon]";
+    case Type::Color: {
+        auto color = as_color();
+        length = snprintf(buffer.characters, sizeof(buffer.characters), "rgba(%d, %d, %d, %d)", color.red(), color.green(), color.blue(), color.alpha());
+        return buffer.characters;
+    }
+    case Type::Invalid:
+        break;
+    }
+    ASSERT_NOT_REACHED();
+}
@@ -11,11 +11,21 @@ public:
     GVariant(float);
     GVariant(int);
     GVariant(const String&);
+    GVariant(const char*);
+    GVariant(const char*, int length);
     GVariant(const GraphicsBitmap&);
     GVariant(const GIcon&);
     GVariant(Color);
+    GVariant(const GVariant&);
+    GVariant(GVariant&&);
     ~GVariant();
 
+    GVariant& operator=(const GVariant&);
+    GVariant& operator=(GVariant&&);
+
+    // Strings up to this long are stored inside the GVariant itself, so making one doesn't allocate.
+    static const int inline_string_capacity = 15;
+
     enum class Type {
         Invalid,
         Bool,
@@ -58,7 +68,26 @@ public:
     String as_string() const
     {
         ASSERT(type() == Type::String);
-        return *m_value.as_string;
+        if (m_string_is_inline)
+            return String(m_value.as_inline_string, m_inline_string_length);
+        return m_value.as_string ? String(*m_value.as_string) : String();
+    }
+
+    // Like as_string(), but without allocating. Null for a null String.
+    const char* string_characters() const
+    {
+        ASSERT(type() == Type::String);
+        if (m_string_is_inline)
+            return m_value.as_inline_string;
+        return m_value.as_string ? m_value.as_string->characters() : nullptr;
+    }
+
+    int string_length() const
+    {
+        ASSERT(type() == Type::String);
+        if (m_string_is_inline)
+            return m_inline_string_length;
+        return m_value.as_string ? m_value.as_string->length() : 0;
     }
 
     const GraphicsBitmap& as_bitmap() const
@@ -88,19 +117,33 @@ public:
 
     String to_string() const;
 
+    // The same text as to_string(), but without allocating for strings, numbers and booleans.
+    // Numbers are formatted into 'buffer', so the result is valid as long as both it and this GVariant are.
+    struct TextBuffer {
+        char characters[32];
+    };
+    const char* to_text(TextBuffer& buffer, int& length) const;
+
     bool operator==(const GVariant&) const;
     bool operator<(const GVariant&) const;
 
 private:
+    void clear();
+    void copy_from(const GVariant&);
+    void move_from(GVariant&&);
+
     union {
         StringImpl* as_string;
+        char as_inline_string[inline_string_capacity + 1];
         GraphicsBitmap* as_bitmap;
         GIconImpl* as_icon;
         bool as_bool;
         int as_int;
         float as_float;
         RGBA32 as_color;
-    } m_value; 
+    } m_value;
 
     Type m_type { Type::Invalid };
+    bool m_string_is_inline { false };
+    byte m_inline_string_length { 0 };
 };
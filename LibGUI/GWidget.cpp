@@ -4,6 +4,7 @@
 #include "GWindow.h"
 #include <LibGUI/GLayout.h>
 #include <AK/Assertions.h>
+#include <AK/TemporaryChange.h>
 #include <SharedGraphics/GraphicsBitmap.h>
 #include <LibGUI/GPainter.h>
 
@@ -26,10 +27,14 @@ void GWidget::child_event(GChildEvent& event)
     if (event.type() == GEvent::ChildAdded) {
         if (event.child() && event.child()->is_widget() && layout())
             layout()->add_widget(static_cast<GWidget&>(*event.child()));
+        if (event.child() && event.child()->is_widget())
+            update(static_cast<GWidget&>(*event.child()).relative_rect());
     }
     if (event.type() == GEvent::ChildRemoved) {
         if (event.child() && event.child()->is_widget() && layout())
             layout()->remove_widget(static_cast<GWidget&>(*event.child()));
+        // A deleted child is gone by now, and took the rect it was painted at with it.
+        update();
     }
     return GObject::child_event(event);
 }
@@ -39,6 +44,10 @@ void GWidget::set_relative_rect(const Rect& rect)
     if (rect == m_relative_rect)
         return;
     bool size_changed = m_relative_rect.size() != rect.size();
+    // Whatever was painted where we used to be (in the window and in any paint cache) has to be repainted.
+    auto* parent = parent_widget();
+    if (parent && is_visible())
+        parent->update(m_relative_rect);
     m_relative_rect = rect;
 
     if (size_changed) {
@@ -86,25 +95,34 @@ void GWidget::event(GEvent& event)
 void GWidget::handle_paint_event(GPaintEvent& event)
 {
     ASSERT(is_visible());
-    if (fill_with_background_color()) {
-        GPainter painter(*this);
-        painter.fill_rect(event.rect(), background_color());
-    } else {
+    if (m_paint_cache_enabled && !m_rendering_paint_cache) {
+        paint_from_cache(event.rect());
+        return;
+    }
+    if (!is_covered_by_opaque_child(event.rect())) {
+        if (fill_with_background_color()) {
+            GPainter painter(*this);
+            painter.fill_rect(event.rect(), background_color());
+        } else {
 #ifdef DEBUG_WIDGET_UNDERDRAW
-        // FIXME: This is a bit broken.
-        // If the widget is not opaque, let's not mess it up with debugging color.
-        GPainter painter(*this);
-        painter.fill_rect(rect(), Color::Red);
+            // FIXME: This is a bit broken.
+            // If the widget is not opaque, let's not mess it up with debugging color.
+            GPainter painter(*this);
+            painter.fill_rect(rect(), Color::Red);
 #endif
+        }
+        paint_event(event);
     }
-    paint_event(event);
-    for (auto* ch : children()) {
-        auto* child = (GWidget*)ch;
+    for (int i = 0; i < children().size(); ++i) {
+        auto* child = (GWidget*)children()[i];
         if (!child->is_visible())
             continue;
         if (child->relative_rect().intersects(event.rect())) {
             auto local_rect = event.rect();
             local_rect.intersect(child->relative_rect());
+            // Children paint in order, so a later opaque sibling would paint over all of this one.
+            if (is_covered_by_opaque_child(local_rect, i + 1))
+                continue;
             local_rect.move_by(-child->relative_rect().x(), -child->relative_rect().y());
             GPaintEvent local_event(local_rect);
             child->event(local_event);
@@ -112,6 +130,55 @@ void GWidget::handle_paint_event(GPaintEvent& event)
     }
 }
 
+bool GWidget::is_covered_by_opaque_child(const Rect& rect, int first_child_index)
+{
+    for (int i = first_child_index; i < children().size(); ++i) {
+        if (!children()[i]->is_widget())
+            continue;
+        auto& child = *(GWidget*)children()[i];
+        if (child.is_visible() && child.is_opaque() && child.relative_rect().contains(rect))
+            return true;
+    }
+    return false;
+}
+
+void GWidget::set_paint_cache_enabled(bool enabled)
+{
+    if (m_paint_cache_enabled == enabled)
+        return;
+    m_paint_cache_enabled = enabled;
+    m_paint_cache = nullptr;
+    m_paint_cache_dirty_rect = { };
+    update();
+}
+
+void GWidget::paint_from_cache(const Rect& rect)
+{
+    if (!m_paint_cache || m_paint_cache->size() != size()) {
+        m_paint_cache = GraphicsBitmap::create(GraphicsBitmap::Format::RGB32, size());
+        m_paint_cache_dirty_rect = this->rect();
+    }
+    if (!m_paint_cache_dirty_rect.is_empty()) {
+        GPaintEvent cache_event(m_paint_cache_dirty_rect);
+        m_paint_cache_dirty_rect = { };
+        TemporaryChange<bool> change(m_rendering_paint_cache, true);
+        handle_paint_event(cache_event);
+    }
+    GPainter painter(*this);
+    painter.blit(rect.location(), *m_paint_cache, rect);
+}
+
+GWidget::PaintTarget GWidget::paint_target()
+{
+    Point origin;
+    for (auto* widget = this; widget; widget = widget->parent_widget()) {
+        if (widget->m_rendering_paint_cache)
+            return { widget->m_paint_cache.ptr(), origin };
+        origin.move_by(widget->relative_position());
+    }
+    return { window()->back_bitmap(), origin };
+}
+
 void GWidget::set_layout(OwnPtr<GLayout>&& layout)
 {
     if (m_layout.ptr() == layout.ptr())
@@ -242,6 +309,12 @@ void GWidget::update(const Rect& rect)
 {
     if (!is_visible())
         return;
+    auto dirty_rect = rect;
+    for (auto* widget = this; widget; widget = widget->parent_widget()) {
+        if (widget->m_paint_cache_enabled)
+            widget->m_paint_cache_dirty_rect = widget->m_paint_cache_dirty_rect.united(Rect::intersection(dirty_rect, widget->rect()));
+        dirty_rect.move_by(widget->relative_position());
+    }
     auto* w = window();
     if (!w)
         return;
@@ -360,8 +433,11 @@ void GWidget::set_visible(bool visible)
     if (visible == m_visible)
         return;
     m_visible = visible;
-    if (auto* parent = parent_widget())
+    if (auto* parent = parent_widget()) {
         parent->invalidate_layout();
+        if (!m_visible)
+            parent->update(m_relative_rect);
+    }
     if (m_visible)
         update();
 }
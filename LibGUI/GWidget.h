@@ -128,6 +128,24 @@ public:
     void set_fill_with_background_color(bool b) { m_fill_with_background_color = b; }
     bool fill_with_background_color() const { return m_fill_with_background_color; }
 
+    // Keep this widget's rendering (children included) in a bitmap, and only repaint the parts of it that
+    // update() was called for since. Only for widgets that paint every pixel they cover, and that call
+    // update() whenever their appearance changes.
+    void set_paint_cache_enabled(bool);
+    bool is_paint_cache_enabled() const { return m_paint_cache_enabled; }
+
+    // Opaque widgets paint every pixel they cover, so nothing underneath them needs painting.
+    // A paint cache doesn't make a widget opaque: the cache holds whatever the widget painted, gaps included.
+    bool is_opaque() const { return m_fill_with_background_color; }
+
+    // Where painting this widget goes right now: the window's back buffer, or the paint cache of
+    // this widget or an ancestor that is being re-rendered. 'origin' is our top left in that bitmap.
+    struct PaintTarget {
+        GraphicsBitmap* bitmap { nullptr };
+        Point origin;
+    };
+    PaintTarget paint_target();
+
     const Font& font() const { return *m_font; }
     void set_font(RetainPtr<Font>&&);
 
@@ -146,6 +164,8 @@ private:
     virtual bool is_widget() const final { return true; }
 
     void handle_paint_event(GPaintEvent&);
+    void paint_from_cache(const Rect&);
+    bool is_covered_by_opaque_child(const Rect&, int first_child_index = 0);
     void handle_resize_event(GResizeEvent&);
     void handle_mousedown_event(GMouseEvent&);
     void handle_mouseup_event(GMouseEvent&);
@@ -165,6 +185,10 @@ private:
 
     bool m_fill_with_background_color { false };
     bool m_visible { true };
+    bool m_paint_cache_enabled { false };
+    bool m_rendering_paint_cache { false };
+    RetainPtr<GraphicsBitmap> m_paint_cache;
+    Rect m_paint_cache_dirty_rect;
 
     GElapsedTimer m_click_clock;
 };
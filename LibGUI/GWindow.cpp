@@ -84,6 +84,7 @@ void GWindow::hide()
     request.type = WSAPI_ClientMessage::Type::DestroyWindow;
     request.window_id = m_window_id;
     GEventLoop::current().post_message_to_server(request);
+    m_frame_callbacks.clear();
 }
 
 void GWindow::set_title(const String& title)
@@ -193,23 +194,26 @@ void GWindow::event(GEvent& event)
     }
 
     if (event.is_paint_event()) {
-        m_pending_paint_event_rects.clear();
-        if (!m_main_widget)
-            return;
+        m_pending_paint_event_region.clear();
         auto& paint_event = static_cast<GPaintEvent&>(event);
         auto rect = paint_event.rect();
-        bool created_new_backing_store = !m_back_bitmap;
-        if (!m_back_bitmap)
-            m_back_bitmap = create_backing_bitmap(paint_event.window_size());
-        if (rect.is_empty() || created_new_backing_store)
-            rect = m_main_widget->rect();
-
-        m_main_widget->event(*make<GPaintEvent>(rect));
-
-        if (m_double_buffering_enabled)
-            flip(rect);
-        else if (created_new_backing_store)
-            set_current_backing_bitmap(*m_back_bitmap, true);
+        if (!m_main_widget) {
+            // The server won't send us another paint until we've answered this one.
+            rect = { };
+        } else {
+            bool created_new_backing_store = !m_back_bitmap;
+            if (!m_back_bitmap)
+                m_back_bitmap = create_backing_bitmap(paint_event.window_size());
+            if (rect.is_empty() || created_new_backing_store)
+                rect = m_main_widget->rect();
+
+            m_main_widget->event(*make<GPaintEvent>(rect));
+
+            if (m_double_buffering_enabled)
+                flip(rect);
+            else if (created_new_backing_store)
+                set_current_backing_bitmap(*m_back_bitmap, true);
+        }
 
         if (m_window_id) {
             WSAPI_ClientMessage message;
@@ -238,6 +242,18 @@ void GWindow::event(GEvent& event)
         return;
     }
 
+    if (event.type() == GEvent::FrameCallback) {
+        auto callbacks = move(m_frame_callbacks);
+        for (auto& callback : callbacks)
+            callback();
+        return;
+    }
+
+    if (event.type() == GEvent::DeferredInvalidate) {
+        flush_invalidations();
+        return;
+    }
+
     if (event.type() == GEvent::WindowCloseRequest) {
         close();
         return;
@@ -252,7 +268,7 @@ void GWindow::event(GEvent& event)
         auto new_size = static_cast<GResizeEvent&>(event).size();
         if (m_back_bitmap && m_back_bitmap->size() != new_size)
             m_back_bitmap = nullptr;
-        m_pending_paint_event_rects.clear();
+        m_pending_paint_event_region.clear();
         m_rect_when_windowless = { { }, new_size };
         m_main_widget->set_relative_rect({ { }, new_size });
         return;
@@ -273,23 +289,56 @@ void GWindow::update(const Rect& a_rect)
 {
     if (!m_window_id)
         return;
-    for (auto& pending_rect : m_pending_paint_event_rects) {
-        if (pending_rect.contains(a_rect)) {
+    // An empty rect means the whole window.
+    auto rect = a_rect;
+    if (rect.is_empty()) {
+        if (!m_main_widget)
+            return;
+        rect = m_main_widget->rect();
+    }
+    if (m_pending_paint_event_region.contains(rect)) {
 #ifdef UPDATE_COALESCING_DEBUG
-            dbgprintf("Ignoring %s since it's contained by pending rect %s\n", a_rect.to_string().characters(), pending_rect.to_string().characters());
+        dbgprintf("Ignoring %s since it's already covered by pending paints\n", rect.to_string().characters());
 #endif
-            return;
-        }
+        return;
     }
-    m_pending_paint_event_rects.append(a_rect);
+    m_pending_paint_event_region.add(rect);
+
+    // Collect everything invalidated during this pass through the event loop, and send it off in one go.
+    if (m_invalidated_region.is_empty())
+        GEventLoop::current().post_event(*this, make<GEvent>(GEvent::DeferredInvalidate));
+    m_invalidated_region.add(rect);
+}
 
+void GWindow::request_frame_callback(Function<void()>&& callback)
+{
+    if (!m_window_id)
+        return;
+    bool already_requested = !m_frame_callbacks.is_empty();
+    m_frame_callbacks.append(move(callback));
+    if (already_requested)
+        return;
     WSAPI_ClientMessage request;
-    request.type = WSAPI_ClientMessage::Type::InvalidateRect;
+    request.type = WSAPI_ClientMessage::Type::RequestFrameCallback;
     request.window_id = m_window_id;
-    request.window.rect = a_rect;
     GEventLoop::current().post_message_to_server(request);
 }
 
+void GWindow::flush_invalidations()
+{
+    auto region = move(m_invalidated_region);
+    if (!m_window_id)
+        return;
+    region.simplify(8, 25);
+    for (auto& rect : region.rects()) {
+        WSAPI_ClientMessage request;
+        request.type = WSAPI_ClientMessage::Type::InvalidateRect;
+        request.window_id = m_window_id;
+        request.window.rect = rect;
+        GEventLoop::current().post_message_to_server(request);
+    }
+}
+
 void GWindow::set_main_widget(GWidget* widget)
 {
     if (m_main_widget == widget)
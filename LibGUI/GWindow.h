@@ -4,7 +4,10 @@
 #include <LibGUI/GWindowType.h>
 #include <SharedGraphics/Rect.h>
 #include <SharedGraphics/GraphicsBitmap.h>
+#include <SharedGraphics/Region.h>
 #include <AK/AKString.h>
+#include <AK/Function.h>
+#include <AK/Vector.h>
 #include <AK/WeakPtr.h>
 
 class GWidget;
@@ -72,6 +75,10 @@ public:
 
     void update(const Rect& = Rect());
 
+    // Calls 'callback' once, right after the next frame that WindowServer puts on screen.
+    // This is the place to advance animations from, so they run at the compositor's pace.
+    void request_frame_callback(Function<void()>&&);
+
     void set_global_cursor_tracking_widget(GWidget*);
     GWidget* global_cursor_tracking_widget() { return m_global_cursor_tracking_widget.ptr(); }
     const GWidget* global_cursor_tracking_widget() const { return m_global_cursor_tracking_widget.ptr(); }
@@ -108,6 +115,7 @@ private:
     Retained<GraphicsBitmap> create_backing_bitmap(const Size&);
     void set_current_backing_bitmap(GraphicsBitmap&, bool flush_immediately = false);
     void flip(const Rect& dirty_rect);
+    void flush_invalidations();
 
     RetainPtr<GraphicsBitmap> m_front_bitmap;
     RetainPtr<GraphicsBitmap> m_back_bitmap;
@@ -120,7 +128,11 @@ private:
     WeakPtr<GWidget> m_hovered_widget;
     Rect m_rect_when_windowless;
     String m_title_when_windowless;
-    Vector<Rect> m_pending_paint_event_rects;
+    // Everything we've asked to have repainted since the last paint event.
+    Region m_pending_paint_event_region;
+    // The part of that we haven't told the server about yet.
+    Region m_invalidated_region;
+    Vector<Function<void()>> m_frame_callbacks;
     Size m_size_increment;
     Size m_base_size;
     GWindowType m_window_type { GWindowType::Normal };
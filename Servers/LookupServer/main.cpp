@@ -2,13 +2,14 @@
 #include <stdlib.h>
 #include <sys/select.h>
 #include <sys/socket.h>
+#include <sys/time.h>
 #include <arpa/inet.h>
 #include <netinet/in.h>
 #include <unistd.h>
-#include <unistd.h>
 #include <Kernel/Net/IPv4.h>
 #include <AK/AKString.h>
 #include <AK/HashMap.h>
+#include <AK/HashTable.h>
 #include <AK/ByteBuffer.h>
 #include <AK/BufferStream.h>
 #include "DNSPacket.h"
@@ -23,9 +24,54 @@
 
 #define C_IN    1
 
-static Vector<IPv4Address> lookup(const String& hostname, bool& did_timeout);
+#define RCODE_NXDOMAIN 3
+
+static const int max_retries = 3;
+static const qword retry_interval_ms = 1000;
+static const dword negative_ttl = 30;
+// A name whose lookup timed out is only remembered briefly, since the network may just have been down.
+static const dword timeout_ttl = 5;
+static const dword max_ttl = 3600;
+static const int max_cache_size = 1024;
+
+struct CachedLookup {
+    // An empty list means the name is known not to exist.
+    Vector<IPv4Address> addresses;
+    qword expiration_time_ms { 0 };
+};
+
+struct PendingLookup {
+    String hostname;
+    ByteBuffer request;
+    // Everyone who asked for this name while the query was in flight.
+    Vector<int> client_fds;
+    qword deadline_ms { 0 };
+    int retries_left { max_retries };
+};
+
+static int s_upstream_fd = -1;
+static sockaddr_in s_nameserver_address;
+static HashMap<String, Vector<IPv4Address>> s_hosts;
+static HashMap<String, CachedLookup> s_cache;
+static HashMap<word, PendingLookup> s_pending_lookups;
+static HashMap<String, word> s_pending_lookup_ids;
+
+static void load_hosts();
+static void load_nameserver();
+static void handle_request(int client_fd, const String& hostname);
+static void handle_response(const byte*, int size);
+static void handle_timeouts();
+static void send_request(PendingLookup&);
+static void respond(int client_fd, const Vector<IPv4Address>&);
 static String parse_dns_name(const byte*, int& offset, int max_offset);
 
+static qword now_ms()
+{
+    timeval now;
+    gettimeofday(&now, nullptr);
+    return (qword)now.tv_sec * 1000 + now.tv_usec / 1000;
+}
+
 int main(int argc, char**argv)
 {
     (void)argc;
@@ -33,7 +79,8 @@ int main(int argc, char**argv)
 
     unlink("/tmp/.LookupServer-socket");
 
-    HashMap<String, IPv4Address> dns_cache;
+    load_hosts();
+    load_nameserver();
 
     int server_fd = socket(AF_LOCAL, SOCK_STREAM | SOCK_CLOEXEC, 0);
     if (server_fd < 0) {
@@ -56,95 +103,167 @@ int main(int argc, char**argv)
         return 1;
     }
 
+    // All upstream queries share one socket, and responses are matched up by their DNS packet ID.
+    s_upstream_fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (s_upstream_fd < 0) {
+        perror("socket");
+        return 1;
+    }
+
+    // Clients we've accepted, but haven't gotten a request from yet.
+    HashTable<int> new_clients;
+
     for (;;) {
         fd_set rfds;
         FD_ZERO(&rfds);
         FD_SET(server_fd, &rfds);
-        rc = select(server_fd + 1, &rfds, nullptr, nullptr, nullptr);
-        if (rc < 1) {
-            perror("select");
-            return 1;
+        FD_SET(s_upstream_fd, &rfds);
+        int max_fd = max(server_fd, s_upstream_fd);
+        for (int client_fd : new_clients) {
+            FD_SET(client_fd, &rfds);
+            max_fd = max(max_fd, client_fd);
         }
 
-        sockaddr_un client_address;
-        socklen_t client_address_size = sizeof(client_address);
-        int client_fd = accept(server_fd, (sockaddr*)&client_address, &client_address_size);
-        if (client_fd < 0) {
-            perror("accept");
-            continue;
+        struct timeval timeout;
+        struct timeval* timeout_ptr = nullptr;
+        if (!s_pending_lookups.is_empty()) {
+            qword now = now_ms();
+            qword next_deadline = (qword)-1;
+            for (auto& it : s_pending_lookups)
+                next_deadline = min(next_deadline, it.value.deadline_ms);
+            qword wait_ms = next_deadline > now ? next_deadline - now : 0;
+            timeout.tv_sec = wait_ms / 1000;
+            timeout.tv_usec = (wait_ms % 1000) * 1000;
+            timeout_ptr = &timeout;
         }
 
-        FD_ZERO(&rfds);
-        FD_SET(client_fd, &rfds);
-        rc = select(client_fd + 1, &rfds, nullptr, nullptr, nullptr);
-        if (rc < 1) {
+        rc = select(max_fd + 1, &rfds, nullptr, nullptr, timeout_ptr);
+        if (rc < 0) {
             perror("select");
             return 1;
         }
 
-        char client_buffer[1024];
-        int nrecv = read(client_fd, client_buffer, sizeof(client_buffer) - 1);
-        if (nrecv < 0) {
-            perror("recv");
-            close(client_fd);
-            continue;
+        if (FD_ISSET(server_fd, &rfds)) {
+            sockaddr_un client_address;
+            socklen_t client_address_size = sizeof(client_address);
+            int client_fd = accept(server_fd, (sockaddr*)&client_address, &client_address_size);
+            if (client_fd < 0) {
+                perror("accept");
+            } else if (client_fd >= FD_SETSIZE) {
+                fprintf(stderr, "LookupServer: Too many clients, dropping one :(\n");
+                close(client_fd);
+            } else {
+                new_clients.set(client_fd);
+            }
         }
 
-        client_buffer[nrecv] = '\0';
-
-        auto hostname = String(client_buffer, nrecv, Chomp);
-        dbgprintf("LookupServer: Got request for '%s'\n", hostname.characters());
+        if (FD_ISSET(s_upstream_fd, &rfds)) {
+            struct sockaddr_in src_addr;
+            socklen_t src_addr_len = sizeof(src_addr);
+            byte response_buffer[4096];
+            ssize_t nrecv = recvfrom(s_upstream_fd, response_buffer, sizeof(response_buffer) - 1, 0, (struct sockaddr*)&src_addr, &src_addr_len);
+            if (nrecv < 0)
+                perror("recvfrom");
+            else
+                handle_response(response_buffer, nrecv);
+        }
 
-        Vector<IPv4Address> addresses;
+        Vector<int> ready_clients;
+        for (int client_fd : new_clients) {
+            if (FD_ISSET(client_fd, &rfds))
+                ready_clients.append(client_fd);
+        }
+        for (int client_fd : ready_clients) {
+            new_clients.remove(client_fd);
 
-        if (!hostname.is_empty()) {
-            bool did_timeout;
-            int retries = 3;
-            do {
-                did_timeout = false;
-                addresses = lookup(hostname, did_timeout);
-                if (!did_timeout)
-                    break;
-            } while (--retries);
-            if (did_timeout) {
-                fprintf(stderr, "LookupServer: Out of retries :(\n");
+            char client_buffer[1024];
+            int nrecv = read(client_fd, client_buffer, sizeof(client_buffer) - 1);
+            if (nrecv < 0) {
+                perror("recv");
                 close(client_fd);
                 continue;
             }
+
+            client_buffer[nrecv] = '\0';
+
+            auto hostname = String(client_buffer, nrecv, Chomp);
+            dbgprintf("LookupServer: Got request for '%s'\n", hostname.characters());
+            handle_request(client_fd, hostname);
         }
 
-        if (addresses.is_empty()) {
-            int nsent = write(client_fd, "Not found.\n", sizeof("Not found.\n"));
-            if (nsent < 0)
-                perror("write");
-            close(client_fd);
+        handle_timeouts();
+    }
+    return 0;
+}
+
+static void load_hosts()
+{
+    FILE* file = fopen("/etc/hosts", "r");
+    if (!file)
+        return;
+    char line[256];
+    while (fgets(line, sizeof(line), file)) {
+        if (line[0] == '#')
             continue;
+        // Lines look like "address name [aliases...]"
+        Vector<String> fields;
+        for (auto& field : String(line, Chomp).split(' ')) {
+            for (auto& part : field.split('\t'))
+                fields.append(part);
         }
-        for (auto& address : addresses) {
-            auto line = String::format("%s\n", address.to_string().characters());
-            int nsent = write(client_fd, line.characters(), line.length());
-            if (nsent < 0) {
-                perror("write");
-                break;
-            }
+        if (fields.size() < 2)
+            continue;
+        IPv4Address address;
+        if (inet_pton(AF_INET, fields[0].characters(), &address) <= 0)
+            continue;
+        for (int i = 1; i < fields.size(); ++i) {
+            if (!s_hosts.contains(fields[i]))
+                s_hosts.set(fields[i], { });
+            (*s_hosts.find(fields[i])).value.append(address);
         }
-        close(client_fd);
     }
-    return 0;
+    fclose(file);
+}
+
+static void load_nameserver()
+{
+    memset(&s_nameserver_address, 0, sizeof(s_nameserver_address));
+    s_nameserver_address.sin_family = AF_INET;
+    s_nameserver_address.sin_port = htons(53);
+    // QEMU's user mode networking answers DNS here, on the 192.168.5.0/24 network the kernel sets up.
+    inet_pton(AF_INET, "192.168.5.3", &s_nameserver_address.sin_addr);
+
+    FILE* file = fopen("/etc/resolv.conf", "r");
+    if (!file)
+        return;
+    char line[256];
+    while (fgets(line, sizeof(line), file)) {
+        // Lines look like "nameserver address". Only the first nameserver is used.
+        auto fields = String(line, Chomp).split(' ');
+        if (fields.size() < 2 || fields[0] != "nameserver")
+            continue;
+        IPv4Address address;
+        if (inet_pton(AF_INET, fields[1].characters(), &address) <= 0)
+            continue;
+        memcpy(&s_nameserver_address.sin_addr, &address, sizeof(address));
+        break;
+    }
+    fclose(file);
 }
 
 static word get_next_id()
 {
     static word s_next_id = 0;
-    return ++s_next_id;
+    do {
+        ++s_next_id;
+    } while (!s_next_id || s_pending_lookups.contains(s_next_id));
+    return s_next_id;
 }
 
-Vector<IPv4Address> lookup(const String& hostname, bool& did_timeout)
+static ByteBuffer build_request(word id, const String& hostname)
 {
-    // FIXME: First check if it's an IP address in a string!
-
     DNSPacket request_header;
-    request_header.set_id(get_next_id());
+    request_header.set_id(id);
     request_header.set_is_query();
     request_header.set_opcode(0);
     request_header.set_truncated(false);
@@ -166,101 +285,185 @@ Vector<IPv4Address> lookup(const String& hostname, bool& did_timeout)
         stream << htons(C_IN);
         stream.snip();
     }
+    return buffer;
+}
 
-    int fd = socket(AF_INET, SOCK_DGRAM, 0);
-    if (fd < 0) {
-        perror("socket");
-        return { };
+static void cache(const String& hostname, const Vector<IPv4Address>& addresses, dword ttl)
+{
+    if (s_cache.size() >= max_cache_size && !s_cache.contains(hostname))
+        s_cache.remove_one_randomly();
+    s_cache.set(hostname, { addresses, now_ms() + (qword)min(ttl, max_ttl) * 1000 });
+}
+
+void handle_request(int client_fd, const String& hostname)
+{
+    // FIXME: First check if it's an IP address in a string!
+    if (hostname.is_empty()) {
+        respond(client_fd, { });
+        return;
     }
 
-    struct timeval timeout { 1, 0 };
-    int rc = setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
-    if (rc < 0) {
-        perror("setsockopt");
-        close(fd);
-        return { };
+    auto hosts_it = s_hosts.find(hostname);
+    if (hosts_it != s_hosts.end()) {
+        respond(client_fd, (*hosts_it).value);
+        return;
     }
 
-    struct sockaddr_in dst_addr;
-    memset(&dst_addr, 0, sizeof(dst_addr));
+    auto cache_it = s_cache.find(hostname);
+    if (cache_it != s_cache.end()) {
+        if ((*cache_it).value.expiration_time_ms > now_ms()) {
+            respond(client_fd, (*cache_it).value.addresses);
+            return;
+        }
+        s_cache.remove(cache_it);
+    }
 
-    dst_addr.sin_family = AF_INET;
-    dst_addr.sin_port = htons(53);
-    rc = inet_pton(AF_INET, "127.0.0.53", &dst_addr.sin_addr);
+    // Someone else is already waiting for this name, so just tag along.
+    auto pending_it = s_pending_lookup_ids.find(hostname);
+    if (pending_it != s_pending_lookup_ids.end()) {
+        auto& lookup = (*s_pending_lookups.find((*pending_it).value)).value;
+        lookup.client_fds.append(client_fd);
+        return;
+    }
+
+    word id = get_next_id();
+    PendingLookup lookup;
+    lookup.hostname = hostname;
+    lookup.request = build_request(id, hostname);
+    lookup.client_fds.append(client_fd);
+    s_pending_lookups.set(id, move(lookup));
+    s_pending_lookup_ids.set(hostname, id);
+    send_request((*s_pending_lookups.find(id)).value);
+}
 
-    int nsent = sendto(fd, buffer.pointer(), buffer.size(), 0,(const struct sockaddr *)&dst_addr, sizeof(dst_addr));
+void send_request(PendingLookup& lookup)
+{
+    lookup.deadline_ms = now_ms() + retry_interval_ms;
+    int nsent = sendto(s_upstream_fd, lookup.request.pointer(), lookup.request.size(), 0, (const struct sockaddr*)&s_nameserver_address, sizeof(s_nameserver_address));
     if (nsent < 0) {
         perror("sendto");
-        return { };
+        return;
+    }
+    ASSERT(nsent == lookup.request.size());
+}
+
+static void finish_lookup(word id, const Vector<IPv4Address>& addresses)
+{
+    auto it = s_pending_lookups.find(id);
+    ASSERT(it != s_pending_lookups.end());
+    auto client_fds = move((*it).value.client_fds);
+    s_pending_lookup_ids.remove((*it).value.hostname);
+    s_pending_lookups.remove(it);
+    for (int client_fd : client_fds)
+        respond(client_fd, addresses);
+}
+
+void handle_timeouts()
+{
+    qword now = now_ms();
+    Vector<word> expired_ids;
+    for (auto& it : s_pending_lookups) {
+        if (it.value.deadline_ms <= now)
+            expired_ids.append(it.key);
     }
-    ASSERT(nsent == buffer.size());
-
-    struct sockaddr_in src_addr;
-    socklen_t src_addr_len = sizeof(src_addr);
-    byte response_buffer[4096];
-    ssize_t nrecv = recvfrom(fd, response_buffer, sizeof(response_buffer) - 1, 0, (struct sockaddr*)&src_addr, &src_addr_len);
-    if (nrecv < 0) {
-        if (errno == EAGAIN) {
-            did_timeout = true;
-        } else {
-            perror("recvfrom");
+    for (word id : expired_ids) {
+        auto& lookup = (*s_pending_lookups.find(id)).value;
+        if (--lookup.retries_left) {
+            send_request(lookup);
+            continue;
         }
-        close(fd);
-        return { };
+        fprintf(stderr, "LookupServer: Out of retries for '%s' :(\n", lookup.hostname.characters());
+        cache(lookup.hostname, { }, timeout_ttl);
+        finish_lookup(id, { });
     }
-    close(fd);
-
-    response_buffer[nrecv] = '\0';
+}
 
+void handle_response(const byte* response_buffer, int nrecv)
+{
     if (nrecv < (int)sizeof(DNSPacket)) {
         dbgprintf("LookupServer: Response not big enough (%d) to be a DNS packet :(\n", nrecv);
-        return { };
+        return;
     }
 
-    auto& response_header = *(DNSPacket*)(response_buffer);
+    auto& response_header = *(const DNSPacket*)(response_buffer);
     dbgprintf("Got response (ID: %u)\n", response_header.id());
     dbgprintf("  Question count: %u\n", response_header.question_count());
     dbgprintf("  Answer count: %u\n", response_header.answer_count());
     dbgprintf(" Authority count: %u\n", response_header.authority_count());
     dbgprintf("Additional count: %u\n", response_header.additional_count());
 
-    if (response_header.id() != request_header.id()) {
-        dbgprintf("LookupServer: ID mismatch (%u vs %u) :(\n", response_header.id(), request_header.id());
-        return { };
+    auto it = s_pending_lookups.find(response_header.id());
+    if (it == s_pending_lookups.end()) {
+        dbgprintf("LookupServer: No pending lookup with ID %u :(\n", response_header.id());
+        return;
     }
+    String hostname = (*it).value.hostname;
+
     if (response_header.question_count() != 1) {
-        dbgprintf("LookupServer: Question count (%u vs %u) :(\n", response_header.question_count(), request_header.question_count());
-        return { };
+        dbgprintf("LookupServer: Question count (%u vs %u) :(\n", response_header.question_count(), 1);
+        finish_lookup(response_header.id(), { });
+        return;
     }
-    if (response_header.answer_count() < 1) {
-        dbgprintf("LookupServer: Not enough answers (%u) :(\n", response_header.answer_count());
-        return { };
+    if (response_header.response_code() == RCODE_NXDOMAIN || response_header.answer_count() < 1) {
+        dbgprintf("LookupServer: No answers for '%s' (rcode=%u) :(\n", hostname.characters(), response_header.response_code());
+        cache(hostname, { }, negative_ttl);
+        finish_lookup(response_header.id(), { });
+        return;
     }
 
     int offset = 0;
-    auto question = parse_dns_name((const byte*)response_header.payload(), offset, nrecv);
+    int max_offset = nrecv - sizeof(DNSPacket);
+    auto question = parse_dns_name((const byte*)response_header.payload(), offset, max_offset);
     offset += 4;
 
     Vector<IPv4Address> addresses;
+    dword ttl = max_ttl;
 
     for (word i = 0; i < response_header.answer_count(); ++i) {
+        if (offset + (int)sizeof(DNSRecord) > max_offset)
+            break;
         auto& record = *(const DNSRecord*)(&((const byte*)response_header.payload())[offset]);
-        auto ipv4_address = IPv4Address((const byte*)record.data());
-        dbgprintf("LookupServer:     Answer #%u: (question: %s), type=%u, ttl=%u, length=%u, data=%s\n",
+        if (offset + (int)sizeof(DNSRecord) + record.data_length() > max_offset) {
+            dbgprintf("LookupServer: Answer #%u runs past the end of the response :(\n", i);
+            break;
+        }
+        dbgprintf("LookupServer:     Answer #%u: (question: %s), type=%u, ttl=%u, length=%u\n",
             i,
             question.characters(),
             record.type(),
             record.ttl(),
-            record.data_length(),
-            ipv4_address.to_string().characters());
+            record.data_length());
 
         offset += sizeof(DNSRecord) + record.data_length();
-        if (record.type() == T_A)
-            addresses.append(ipv4_address);
+        if (record.type() == T_A && record.data_length() == 4) {
+            addresses.append(IPv4Address((const byte*)record.data()));
+            ttl = min(ttl, record.ttl());
+        }
         // FIXME: Parse some other record types perhaps?
     }
 
-    return addresses;
+    cache(hostname, addresses, addresses.is_empty() ? negative_ttl : ttl);
+    finish_lookup(response_header.id(), addresses);
+}
+
+void respond(int client_fd, const Vector<IPv4Address>& addresses)
+{
+    if (addresses.is_empty()) {
+        int nsent = write(client_fd, "Not found.\n", sizeof("Not found.\n"));
+        if (nsent < 0)
+            perror("write");
+        close(client_fd);
+        return;
+    }
+    for (auto& address : addresses) {
+        auto line = String::format("%s\n", address.to_string().characters());
+        int nsent = write(client_fd, line.characters(), line.length());
+        if (nsent < 0) {
+            perror("write");
+            break;
+        }
+    }
+    close(client_fd);
 }
 
 static String parse_dns_name(const byte* data, int& offset, int max_offset)
@@ -1,7 +1,9 @@
 #pragma once
 
+#include <AK/Vector.h>
 #include <SharedGraphics/Color.h>
 #include <SharedGraphics/Rect.h>
+#include <string.h>
 
 typedef unsigned WSAPI_Color;
 
@@ -95,12 +97,12 @@ struct WSAPI_ServerMessage {
         ScreenRectChanged,
         WM_WindowRemoved,
         WM_WindowStateChanged,
+        FrameCallback,
     };
     Type type { Invalid };
     int window_id { -1 };
-    int text_length { 0 };
-    char text[256];
     int value { 0 };
+    int text_length { 0 };
 
     union {
         struct {
@@ -157,6 +159,9 @@ struct WSAPI_ServerMessage {
             int contents_size;
         } clipboard;
     };
+
+    // NOTE: This has to be last, see wsapi_encode_message().
+    char text[256];
 };
 
 struct WSAPI_ClientMessage {
@@ -189,12 +194,12 @@ struct WSAPI_ClientMessage {
         GetWallpaper,
         SetWindowOverrideCursor,
         WM_SetActiveWindow,
+        RequestFrameCallback,
     };
     Type type { Invalid };
     int window_id { -1 };
-    int text_length { 0 };
-    char text[256];
     int value { 0 };
+    int text_length { 0 };
 
     union {
         struct {
@@ -237,8 +242,57 @@ struct WSAPI_ClientMessage {
             WSAPI_StandardCursor cursor;
         } cursor;
     };
+
+    // NOTE: This has to be last, see wsapi_encode_message().
+    char text[256];
 };
 
+// On the wire, every message is a dword byte count followed by that many bytes of the message.
+// Since 'text' is the last member, only the part of it that's in use gets sent, and the
+// receiver zero-fills the rest. This lets both sides batch any number of messages per write()
+// and pick them apart again from whatever a read() returns.
+template<typename MessageType>
+inline void wsapi_encode_message(Vector<byte>& buffer, const MessageType& message)
+{
+    ASSERT(message.text_length >= 0 && message.text_length <= (int)sizeof(message.text));
+    dword size = __builtin_offsetof(MessageType, text) + message.text_length;
+    buffer.append((const byte*)&size, sizeof(size));
+    buffer.append((const byte*)&message, size);
+}
+
+// Decodes the message at the start of 'data'. Returns the number of bytes it took up,
+// 0 if 'data' doesn't hold all of it yet, or -1 if the data is garbage.
+template<typename MessageType>
+inline int wsapi_decode_message(const byte* data, int size, MessageType& message)
+{
+    dword message_size;
+    if (size < (int)sizeof(message_size))
+        return 0;
+    memcpy(&message_size, data, sizeof(message_size));
+    dword fixed_size = __builtin_offsetof(MessageType, text);
+    if (message_size < fixed_size || message_size > sizeof(MessageType))
+        return -1;
+    if (size < (int)(sizeof(message_size) + message_size))
+        return 0;
+    memset((void*)&message, 0, sizeof(MessageType));
+    memcpy((void*)&message, data + sizeof(message_size), message_size);
+    if (message.text_length < 0 || (dword)message.text_length != message_size - fixed_size)
+        return -1;
+    return sizeof(message_size) + message_size;
+}
+
+// Drops the first 'count' bytes of 'buffer', once the messages in them have been decoded.
+inline void wsapi_consume(Vector<byte>& buffer, int count)
+{
+    ASSERT(count <= buffer.size());
+    if (count == buffer.size()) {
+        buffer.clear_with_capacity();
+        return;
+    }
+    memmove(buffer.data(), buffer.data() + count, buffer.size() - count);
+    buffer.resize(buffer.size() - count);
+}
+
 inline Rect::Rect(const WSAPI_Rect& r) : Rect(r.location, r.size) { }
 inline Point::Point(const WSAPI_Point& p) : Point(p.x, p.y) { }
 inline Size::Size(const WSAPI_Size& s) : Size(s.width, s.height) { }
@@ -72,17 +72,30 @@ void WSClientConnection::post_error(const String& error_message)
 
 void WSClientConnection::post_message(const WSAPI_ServerMessage& message)
 {
-    int nwritten = write(m_fd, &message, sizeof(message));
+    wsapi_encode_message(m_outgoing_buffer, message);
+}
+
+void WSClientConnection::flush_outgoing_messages()
+{
+    if (m_outgoing_buffer.is_empty())
+        return;
+    int nwritten = write(m_fd, m_outgoing_buffer.data(), m_outgoing_buffer.size());
     if (nwritten < 0) {
         if (errno == EPIPE) {
-            dbgprintf("WSClientConnection::post_message: Disconnected from peer.\n");
+            dbgprintf("WSClientConnection::flush_outgoing_messages: Disconnected from peer.\n");
+            m_outgoing_buffer.clear();
             return;
         }
-        perror("WSClientConnection::post_message write");
+        perror("WSClientConnection::flush_outgoing_messages write");
         ASSERT_NOT_REACHED();
     }
 
-    ASSERT(nwritten == sizeof(message));
+    ASSERT(nwritten == m_outgoing_buffer.size());
+    // Hang on to the buffer for next time, unless some burst made it unreasonably big.
+    if (m_outgoing_buffer.capacity() <= 16384)
+        m_outgoing_buffer.clear_with_capacity();
+    else
+        m_outgoing_buffer.clear();
 }
 
 void WSClientConnection::notify_about_new_screen_rect(const Rect& rect)
@@ -253,11 +266,17 @@ void WSClientConnection::handle_request(const WSAPISetWindowOpacityRequest& requ
 
 void WSClientConnection::handle_request(const WSAPISetWallpaperRequest& request)
 {
-    bool success = WSWindowManager::the().set_wallpaper(request.wallpaper());
-    WSAPI_ServerMessage response;
-    response.type = WSAPI_ServerMessage::Type::DidSetWallpaper;
-    response.value = success;
-    post_message(response);
+    int client_id = this->client_id();
+    WSWindowManager::the().set_wallpaper(request.wallpaper(), [client_id] (bool success) {
+        // The client may have gone away while the wallpaper was decoding.
+        auto* client = WSClientConnection::from_client_id(client_id);
+        if (!client)
+            return;
+        WSAPI_ServerMessage response;
+        response.type = WSAPI_ServerMessage::Type::DidSetWallpaper;
+        response.value = success;
+        client->post_message(response);
+    });
 }
 
 void WSClientConnection::handle_request(const WSAPIGetWallpaperRequest&)
@@ -311,7 +330,7 @@ void WSClientConnection::handle_request(const WSAPISetWindowRectRequest& request
     }
     auto& window = *(*it).value;
     window.set_rect(request.rect());
-    post_paint_request(window, request.rect());
+    post_paint_request(window, { });
 }
 
 void WSClientConnection::handle_request(const WSAPIGetWindowRectRequest& request)
@@ -400,14 +419,37 @@ void WSClientConnection::handle_request(const WSAPIDestroyWindowRequest& request
     m_windows.remove(it);
 }
 
-void WSClientConnection::post_paint_request(const WSWindow& window, const Rect& rect)
+void WSClientConnection::post_paint_request(WSWindow& window, const Rect& a_rect)
 {
-    WSAPI_ServerMessage response;
-    response.type = WSAPI_ServerMessage::Type::Paint;
-    response.window_id = window.window_id();
-    response.paint.rect = rect;
-    response.paint.window_size = window.size();
-    post_message(response);
+    // An empty rect means the whole window.
+    Rect window_rect { { }, window.size() };
+    auto rect = a_rect.is_empty() ? window_rect : Rect::intersection(a_rect, window_rect);
+    if (rect.is_empty())
+        return;
+    window.pending_paint_region().add(rect);
+    if (!window.is_waiting_for_paint())
+        WSWindowManager::the().schedule_compose();
+}
+
+void WSClientConnection::flush_pending_paint_requests()
+{
+    for (auto& it : m_windows) {
+        auto& window = *it.value;
+        if (window.is_waiting_for_paint() || window.pending_paint_region().is_empty())
+            continue;
+        // The window may have shrunk since the damage came in.
+        auto rect = Rect::intersection(window.pending_paint_region().bounding_rect(), { { }, window.size() });
+        window.pending_paint_region().clear();
+        if (rect.is_empty())
+            continue;
+        WSAPI_ServerMessage message;
+        message.type = WSAPI_ServerMessage::Type::Paint;
+        message.window_id = window.window_id();
+        message.paint.rect = rect;
+        message.paint.window_size = window.size();
+        post_message(message);
+        window.set_waiting_for_paint(true);
+    }
 }
 
 void WSClientConnection::handle_request(const WSAPIInvalidateRectRequest& request)
@@ -422,6 +464,34 @@ void WSClientConnection::handle_request(const WSAPIInvalidateRectRequest& reques
     post_paint_request(window, request.rect());
 }
 
+void WSClientConnection::handle_request(const WSAPIRequestFrameCallbackRequest& request)
+{
+    int window_id = request.window_id();
+    auto it = m_windows.find(window_id);
+    if (it == m_windows.end()) {
+        post_error("Bad window ID");
+        return;
+    }
+    auto& window = *(*it).value;
+    window.set_wants_frame_callback(true);
+    WSWindowManager::the().schedule_compose();
+}
+
+void WSClientConnection::post_frame_callbacks(unsigned frame)
+{
+    for (auto& it : m_windows) {
+        auto& window = *it.value;
+        if (!window.wants_frame_callback())
+            continue;
+        window.set_wants_frame_callback(false);
+        WSAPI_ServerMessage message;
+        message.type = WSAPI_ServerMessage::Type::FrameCallback;
+        message.window_id = window.window_id();
+        message.value = frame;
+        post_message(message);
+    }
+}
+
 void WSClientConnection::handle_request(const WSAPIDidFinishPaintingNotification& request)
 {
     int window_id = request.window_id();
@@ -432,6 +502,11 @@ void WSClientConnection::handle_request(const WSAPIDidFinishPaintingNotification
     }
     auto& window = *(*it).value;
 
+    // The client caught up, so it can have whatever damage piled up in the meantime next frame.
+    window.set_waiting_for_paint(false);
+    if (!window.pending_paint_region().is_empty())
+        WSWindowManager::the().schedule_compose();
+
     if (!window.has_painted_since_last_resize()) {
         if (window.last_lazy_resize_rect().size() == request.rect().size()) {
             window.set_has_painted_since_last_resize(true);
@@ -517,6 +592,7 @@ void WSClientConnection::handle_request(const WSAPISetWindowOverrideCursorReques
     }
     auto& window = *(*it).value;
     window.set_override_cursor(WSCursor::create(request.cursor()));
+    WSWindowManager::the().invalidate_cursor();
 }
 
 void WSClientConnection::handle_request(const WSWMAPISetActiveWindowRequest& request)
@@ -591,6 +667,8 @@ void WSClientConnection::on_request(const WSAPIClientRequest& request)
         return handle_request(static_cast<const WSAPISetWindowOverrideCursorRequest&>(request));
     case WSMessage::WMAPISetActiveWindowRequest:
         return handle_request(static_cast<const WSWMAPISetActiveWindowRequest&>(request));
+    case WSMessage::APIRequestFrameCallbackRequest:
+        return handle_request(static_cast<const WSAPIRequestFrameCallbackRequest&>(request));
     default:
         break;
     }
@@ -4,6 +4,7 @@
 #include <AK/OwnPtr.h>
 #include <AK/WeakPtr.h>
 #include <AK/Function.h>
+#include <AK/Vector.h>
 #include <SharedGraphics/GraphicsBitmap.h>
 #include <WindowServer/WSMessageReceiver.h>
 #include <WindowServer/WSMessage.h>
@@ -21,7 +22,13 @@ public:
     static WSClientConnection* from_client_id(int client_id);
     static void for_each_client(Function<void(WSClientConnection&)>);
 
+    // Messages are queued up and written out in one go by flush_outgoing_messages(),
+    // which the message loop calls before it goes back to sleep.
     void post_message(const WSAPI_ServerMessage&);
+    void flush_outgoing_messages();
+
+    // Bytes read from the client that don't make up a whole message yet.
+    Vector<byte>& incoming_buffer() { return m_incoming_buffer; }
 
     int client_id() const { return m_client_id; }
     WSMenuBar* app_menubar() { return m_app_menubar.ptr(); }
@@ -37,7 +44,13 @@ public:
     template<typename Callback> void for_each_window(Callback);
 
     void notify_about_new_screen_rect(const Rect&);
-    void post_paint_request(const WSWindow&, const Rect&);
+    // Paint requests are merged per window, and handed out at the start of each frame by
+    // flush_pending_paint_requests(). Each window has at most one paint in flight.
+    void post_paint_request(WSWindow&, const Rect&);
+    void flush_pending_paint_requests();
+
+    // Tells every window that asked for it that frame number 'frame' is now on screen.
+    void post_frame_callbacks(unsigned frame);
 
 private:
     virtual void on_message(const WSMessage&) override;
@@ -69,6 +82,7 @@ private:
     void handle_request(const WSAPIGetWallpaperRequest&);
     void handle_request(const WSAPISetWindowOverrideCursorRequest&);
     void handle_request(const WSWMAPISetActiveWindowRequest&);
+    void handle_request(const WSAPIRequestFrameCallbackRequest&);
 
     void post_error(const String&);
 
@@ -86,6 +100,9 @@ private:
     int m_next_window_id { 1982 };
 
     RetainPtr<SharedBuffer> m_last_sent_clipboard_content;
+
+    Vector<byte> m_outgoing_buffer;
+    Vector<byte> m_incoming_buffer;
 };
 
 template<typename Matching, typename Callback>
@@ -13,6 +13,7 @@ public:
     enum Type {
         Invalid = 0,
         WM_DeferredCompose,
+        WM_DeferredCursorUpdate,
         WM_ClientDisconnected,
         MouseMove,
         MouseDown,
@@ -56,6 +57,7 @@ public:
         APIGetWallpaperRequest,
         APISetWindowOverrideCursorRequest,
         WMAPISetActiveWindowRequest,
+        APIRequestFrameCallbackRequest,
         __End_API_Client_Requests,
     };
 
@@ -511,6 +513,20 @@ private:
     int m_window_id { 0 };
 };
 
+class WSAPIRequestFrameCallbackRequest final : public WSAPIClientRequest {
+public:
+    explicit WSAPIRequestFrameCallbackRequest(int client_id, int window_id)
+        : WSAPIClientRequest(WSMessage::APIRequestFrameCallbackRequest, client_id)
+        , m_window_id(window_id)
+    {
+    }
+
+    int window_id() const { return m_window_id; }
+
+private:
+    int m_window_id { 0 };
+};
+
 class WSAPIDidFinishPaintingNotification final : public WSAPIClientRequest {
 public:
     explicit WSAPIDidFinishPaintingNotification(int client_id, int window_id, const Rect& rect)
@@ -82,24 +82,28 @@ void WSMessageLoop::post_message(WSMessageReceiver& receiver, OwnPtr<WSMessage>&
     m_queued_messages.append({ receiver.make_weak_ptr(), move(message) });
 }
 
-void WSMessageLoop::Timer::reload()
+static qword current_time_in_microseconds()
 {
     struct timeval now;
     gettimeofday(&now, nullptr);
-    next_fire_time = {
-        now.tv_sec + (interval / 1000),
-        now.tv_usec + (interval % 1000) * 1000
-    };
+    return (qword)now.tv_sec * 1000000 + now.tv_usec;
+}
+
+void WSMessageLoop::Timer::reload(qword now)
+{
+    next_fire_time = now + (qword)interval * 1000;
 }
 
-int WSMessageLoop::start_timer(int interval, Function<void()>&& callback)
+int WSMessageLoop::start_timer(int interval, Function<void()>&& callback, bool should_reload)
 {
     auto timer = make<Timer>();
     int timer_id = m_next_timer_id++;
     timer->timer_id = timer_id;
     timer->callback = move(callback);
     timer->interval = interval;
-    timer->reload();
+    timer->should_reload = should_reload;
+    timer->reload(current_time_in_microseconds());
+    m_timer_queue.insert(timer->next_fire_time, timer_id);
     m_timers.set(timer_id, move(timer));
     return timer_id;
 }
@@ -113,6 +117,49 @@ int WSMessageLoop::stop_timer(int timer_id)
     return 0;
 }
 
+void WSMessageLoop::add_read_notifier(int fd, Function<void()>&& callback)
+{
+    m_read_notifiers.append({ fd, move(callback) });
+}
+
+void WSMessageLoop::discard_stopped_timers_from_queue()
+{
+    while (!m_timer_queue.is_empty() && !m_timers.contains(m_timer_queue.peek_min()))
+        m_timer_queue.pop_min();
+}
+
+void WSMessageLoop::fire_expired_timers()
+{
+    qword now = current_time_in_microseconds();
+    Vector<int> expired_timer_ids;
+    while (!m_timer_queue.is_empty() && m_timer_queue.peek_min_key() <= now) {
+        qword fire_time = m_timer_queue.peek_min_key();
+        int timer_id = m_timer_queue.pop_min();
+        if (!m_timers.contains(timer_id))
+            continue;
+        expired_timer_ids.append(timer_id);
+        dword lateness = now - fire_time;
+        ++m_timer_statistics.fired;
+        m_timer_statistics.total_lateness_us += lateness;
+        m_timer_statistics.max_lateness_us = max(m_timer_statistics.max_lateness_us, lateness);
+    }
+    for (int timer_id : expired_timer_ids) {
+        auto it = m_timers.find(timer_id);
+        if (it == m_timers.end())
+            continue; // Stopped by an earlier callback.
+        if ((*it).value->should_reload) {
+            auto& timer = *(*it).value;
+            timer.reload(now);
+            m_timer_queue.insert(timer.next_fire_time, timer_id);
+            timer.callback();
+            continue;
+        }
+        auto timer = move((*it).value);
+        m_timers.remove(it);
+        timer->callback();
+    }
+}
+
 void WSMessageLoop::wait_for_message()
 {
     fd_set rfds;
@@ -127,41 +174,33 @@ void WSMessageLoop::wait_for_message()
     add_fd_to_set(m_keyboard_fd, rfds);
     add_fd_to_set(m_mouse_fd, rfds);
     add_fd_to_set(m_server_fd, rfds);
+    for (auto& notifier : m_read_notifiers)
+        add_fd_to_set(notifier.fd, rfds);
 
     WSClientConnection::for_each_client([&] (WSClientConnection& client) {
+        client.flush_outgoing_messages();
         add_fd_to_set(client.fd(), rfds);
     });
 
+    discard_stopped_timers_from_queue();
     struct timeval timeout = { 0, 0 };
-
-    if (m_queued_messages.is_empty()) {
-        bool had_any_timer = false;
-        for (auto& it : m_timers) {
-            auto& timer = *it.value;
-            if (!had_any_timer) {
-                timeout = timer.next_fire_time;
-                had_any_timer = true;
-                continue;
-            }
-            if (timer.next_fire_time.tv_sec > timeout.tv_sec || (timer.next_fire_time.tv_sec == timeout.tv_sec && timer.next_fire_time.tv_usec > timeout.tv_usec))
-                timeout = timer.next_fire_time;
+    if (m_queued_messages.is_empty() && !m_timer_queue.is_empty()) {
+        // Sleep until the soonest timer is due. select() wants that as a relative time.
+        qword wake_time = m_timer_queue.peek_min_key() + (qword)m_timer_slack_ms * 1000;
+        qword now = current_time_in_microseconds();
+        if (wake_time > now) {
+            // Cap the wait to keep the arithmetic in 32 bits. A longer timer just costs an extra wakeup.
+            dword delay = min(wake_time - now, (qword)1000000000);
+            timeout = { (time_t)(delay / 1000000), (suseconds_t)(delay % 1000000) };
         }
     }
 
-    int rc = select(max_fd + 1, &rfds, nullptr, nullptr, m_queued_messages.is_empty() && m_timers.is_empty() ? nullptr : &timeout);
+    int rc = select(max_fd + 1, &rfds, nullptr, nullptr, m_queued_messages.is_empty() && m_timer_queue.is_empty() ? nullptr : &timeout);
     if (rc < 0) {
         ASSERT_NOT_REACHED();
     }
 
-    struct timeval now;
-    gettimeofday(&now, nullptr);
-    for (auto& it : m_timers) {
-        auto& timer = *it.value;
-        if (now.tv_sec > timer.next_fire_time.tv_sec || (now.tv_sec == timer.next_fire_time.tv_sec && now.tv_usec > timer.next_fire_time.tv_usec)) {
-            timer.callback();
-            timer.reload();
-        }
-    }
+    fire_expired_timers();
 
     if (FD_ISSET(m_keyboard_fd, &rfds))
         drain_keyboard();
@@ -178,26 +217,53 @@ void WSMessageLoop::wait_for_message()
         }
     }
     WSClientConnection::for_each_client([&] (WSClientConnection& client) {
-        if (!FD_ISSET(client.fd(), &rfds))
+        if (FD_ISSET(client.fd(), &rfds))
+            drain_client(client);
+    });
+    for (auto& notifier : m_read_notifiers) {
+        if (FD_ISSET(notifier.fd, &rfds))
+            notifier.callback();
+    }
+}
+
+void WSMessageLoop::drain_client(WSClientConnection& client)
+{
+    auto& buffer = client.incoming_buffer();
+    bool received_anything = false;
+    for (;;) {
+        int old_size = buffer.size();
+        buffer.resize(old_size + 4096);
+        ssize_t nread = read(client.fd(), buffer.data() + old_size, 4096);
+        buffer.resize(old_size + max(nread, (ssize_t)0));
+        if (nread == 0)
+            break;
+        if (nread < 0) {
+            perror("read");
+            ASSERT_NOT_REACHED();
+        }
+        received_anything = true;
+    }
+    if (!received_anything) {
+        notify_client_disconnected(client.client_id());
+        return;
+    }
+
+    int offset = 0;
+    for (;;) {
+        WSAPI_ClientMessage message;
+        int consumed = wsapi_decode_message(buffer.data() + offset, buffer.size() - offset, message);
+        if (!consumed)
+            break;
+        if (consumed < 0) {
+            dbgprintf("WindowServer: Client %d sent a malformed message, disconnecting it.\n", client.client_id());
+            buffer.clear();
+            notify_client_disconnected(client.client_id());
             return;
-        unsigned messages_received = 0;
-        for (;;) {
-            WSAPI_ClientMessage message;
-            // FIXME: Don't go one message at a time, that's so much context switching, oof.
-            ssize_t nread = read(client.fd(), &message, sizeof(WSAPI_ClientMessage));
-            if (nread == 0) {
-                if (!messages_received)
-                    notify_client_disconnected(client.client_id());
-                break;
-            }
-            if (nread < 0) {
-                perror("read");
-                ASSERT_NOT_REACHED();
-            }
-            on_receive_from_client(client.client_id(), message);
-            ++messages_received;
         }
-    });
+        on_receive_from_client(client.client_id(), message);
+        offset += consumed;
+    }
+    wsapi_consume(buffer, offset);
 }
 
 void WSMessageLoop::drain_mouse()
@@ -354,6 +420,9 @@ void WSMessageLoop::on_receive_from_client(int client_id, const WSAPI_ClientMess
     case WSAPI_ClientMessage::Type::WM_SetActiveWindow:
         post_message(client, make<WSWMAPISetActiveWindowRequest>(client_id, message.wm.client_id, message.wm.window_id));
         break;
+    case WSAPI_ClientMessage::Type::RequestFrameCallback:
+        post_message(client, make<WSAPIRequestFrameCallbackRequest>(client_id, message.window_id));
+        break;
     default:
         break;
     }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "WSMessage.h"
+#include <AK/BinaryHeap.h>
 #include <AK/HashMap.h>
 #include <AK/OwnPtr.h>
 #include <AK/Vector.h>
@@ -8,6 +9,7 @@
 #include <AK/WeakPtr.h>
 
 class WSMessageReceiver;
+class WSClientConnection;
 struct WSAPI_ClientMessage;
 struct WSAPI_ServerMessage;
 
@@ -24,9 +26,25 @@ public:
 
     bool running() const { return m_running; }
 
-    int start_timer(int ms, Function<void()>&&);
+    // Timers that don't reload are stopped after firing once. It's fine to stop timers from inside a timer callback,
+    // except for a reloading timer stopping itself.
+    int start_timer(int ms, Function<void()>&&, bool should_reload = true);
     int stop_timer(int timer_id);
 
+    // Lets timers fire up to 'ms' late, so that timers due close together are handled on one wakeup.
+    void set_timer_slack(int ms) { m_timer_slack_ms = ms; }
+
+    struct TimerStatistics {
+        unsigned fired { 0 };
+        qword total_lateness_us { 0 };
+        dword max_lateness_us { 0 };
+    };
+    const TimerStatistics& timer_statistics() const { return m_timer_statistics; }
+
+    // Calls 'callback' from the message loop whenever 'fd' is readable. The callback has to read from 'fd',
+    // or it will be called again right away.
+    void add_read_notifier(int fd, Function<void()>&& callback);
+
     void on_receive_from_client(int client_id, const WSAPI_ClientMessage&);
 
     void notify_client_disconnected(int client_id);
@@ -35,6 +53,9 @@ private:
     void wait_for_message();
     void drain_mouse();
     void drain_keyboard();
+    void drain_client(WSClientConnection&);
+    void discard_stopped_timers_from_queue();
+    void fire_expired_timers();
 
     struct QueuedMessage {
         WeakPtr<WSMessageReceiver> receiver;
@@ -48,15 +69,26 @@ private:
     int m_mouse_fd { -1 };
     int m_server_fd { -1 };
 
+    struct ReadNotifier {
+        int fd { -1 };
+        Function<void()> callback;
+    };
+    Vector<ReadNotifier> m_read_notifiers;
+
     struct Timer {
-        void reload();
+        void reload(qword now);
 
         int timer_id { 0 };
         int interval { 0 };
-        struct timeval next_fire_time { 0, 0 };
+        bool should_reload { true };
+        qword next_fire_time { 0 }; // In microseconds since the epoch.
         Function<void()> callback;
     };
 
     int m_next_timer_id { 1 };
     HashMap<int, OwnPtr<Timer>> m_timers;
+    // Timer ids by fire time. Stopping a timer leaves its entry here; it's dropped when it reaches the front.
+    BinaryHeap<qword, int> m_timer_queue;
+    int m_timer_slack_ms { 0 };
+    TimerStatistics m_timer_statistics;
 };
@@ -210,9 +210,27 @@ void WSWindow::set_visible(bool b)
     if (m_visible == b)
         return;
     m_visible = b;
+    WSWindowManager::the().invalidate_occlusions();
     invalidate();
 }
 
+void WSWindow::set_opacity(float opacity)
+{
+    if (m_opacity == opacity)
+        return;
+    m_opacity = opacity;
+    WSWindowManager::the().invalidate_occlusions();
+    invalidate();
+}
+
+void WSWindow::set_has_alpha_channel(bool value)
+{
+    if (m_has_alpha_channel == value)
+        return;
+    m_has_alpha_channel = value;
+    WSWindowManager::the().invalidate_occlusions();
+}
+
 void WSWindow::set_resizable(bool resizable)
 {
     if (m_resizable == resizable)
@@ -2,6 +2,7 @@
 
 #include <SharedGraphics/Rect.h>
 #include <SharedGraphics/GraphicsBitmap.h>
+#include <SharedGraphics/Region.h>
 #include <AK/AKString.h>
 #include <AK/InlineLinkedList.h>
 #include "WSMessageReceiver.h"
@@ -39,7 +40,7 @@ public:
     void set_title(String&&);
 
     float opacity() const { return m_opacity; }
-    void set_opacity(float opacity) { m_opacity = opacity; }
+    void set_opacity(float);
 
     int x() const { return m_rect.x(); }
     int y() const { return m_rect.y(); }
@@ -101,7 +102,12 @@ public:
     bool global_cursor_tracking() const { return m_global_cursor_tracking_enabled || m_automatic_cursor_tracking_enabled; }
 
     bool has_alpha_channel() const { return m_has_alpha_channel; }
-    void set_has_alpha_channel(bool value) { m_has_alpha_channel = value; }
+    void set_has_alpha_channel(bool);
+
+    // The parts of our frame that aren't covered by an opaque window in front of us.
+    // These are maintained by WSWindowManager, and only valid while we're visible.
+    const Region& visible_region() const { return m_visible_region; }
+    void set_visible_region(Region&& region) { m_visible_region = move(region); }
 
     void set_last_lazy_resize_rect(const Rect& rect) { m_last_lazy_resize_rect = rect; }
     Rect last_lazy_resize_rect() const { return m_last_lazy_resize_rect; }
@@ -109,6 +115,14 @@ public:
     bool has_painted_since_last_resize() const { return m_has_painted_since_last_resize; }
     void set_has_painted_since_last_resize(bool b) { m_has_painted_since_last_resize = b; }
 
+    // Damage (in window coordinates) the client hasn't been asked to repaint yet.
+    Region& pending_paint_region() { return m_pending_paint_region; }
+    bool is_waiting_for_paint() const { return m_waiting_for_paint; }
+    void set_waiting_for_paint(bool b) { m_waiting_for_paint = b; }
+
+    bool wants_frame_callback() const { return m_wants_frame_callback; }
+    void set_wants_frame_callback(bool b) { m_wants_frame_callback = b; }
+
     Size size_increment() const { return m_size_increment; }
     void set_size_increment(const Size& increment) { m_size_increment = increment; }
 
@@ -133,12 +147,16 @@ private:
     WSMessageReceiver* m_internal_owner { nullptr };
     String m_title;
     Rect m_rect;
+    Region m_visible_region;
     WSWindowType m_type { WSWindowType::Normal };
     bool m_global_cursor_tracking_enabled { false };
     bool m_automatic_cursor_tracking_enabled { false };
     bool m_visible { true };
     bool m_has_alpha_channel { false };
     bool m_has_painted_since_last_resize { false };
+    bool m_waiting_for_paint { false };
+    bool m_wants_frame_callback { false };
+    Region m_pending_paint_region;
     bool m_modal { false };
     bool m_resizable { false };
     bool m_listens_to_wm_events { false };
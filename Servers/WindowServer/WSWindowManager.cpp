@@ -5,6 +5,7 @@
 #include <SharedGraphics/Font.h>
 #include <SharedGraphics/Painter.h>
 #include <SharedGraphics/CharacterBitmap.h>
+#include <SharedGraphics/PNGLoader.h>
 #include <AK/StdLibExtras.h>
 #include <errno.h>
 #include "WSMenu.h"
@@ -14,10 +15,12 @@
 #include <unistd.h>
 #include <stdio.h>
 #include <time.h>
+#include <fcntl.h>
+#include <sys/time.h>
 #include <SharedGraphics/StylePainter.h>
-#include <SharedGraphics/PNGLoader.h>
 #include <WindowServer/WSCursor.h>
 #include <WindowServer/WSButton.h>
+#include <Kernel/ProcessStatistics.h>
 
 //#define DEBUG_COUNTERS
 //#define RESIZE_DEBUG
@@ -32,10 +35,32 @@ WSWindowManager& WSWindowManager::the()
     return *s_the;
 }
 
+static int microseconds_since(const struct timeval& then)
+{
+    struct timeval now;
+    gettimeofday(&now, nullptr);
+    int seconds = now.tv_sec - then.tv_sec;
+    if (seconds > 1000)
+        return 1000 * 1000000;
+    return seconds * 1000000 + ((int)now.tv_usec - (int)then.tv_usec);
+}
+
+static void copy_pixels(GraphicsBitmap& dst, const Point& dst_location, const GraphicsBitmap& src, const Rect& src_rect)
+{
+    const RGBA32* src_ptr = src.scanline(src_rect.y()) + src_rect.x();
+    RGBA32* dst_ptr = dst.scanline(dst_location.y()) + dst_location.x();
+    for (int y = 0; y < src_rect.height(); ++y) {
+        fast_dword_copy(dst_ptr, src_ptr, src_rect.width());
+        src_ptr = (const RGBA32*)((const byte*)src_ptr + src.pitch());
+        dst_ptr = (RGBA32*)((byte*)dst_ptr + dst.pitch());
+    }
+}
+
 void WSWindowManager::flip_buffers()
 {
     swap(m_front_bitmap, m_back_bitmap);
     swap(m_front_painter, m_back_painter);
+    swap(m_front_cursor_save_under, m_back_cursor_save_under);
     int new_y_offset = m_buffers_are_flipped ? 0 : m_screen_rect.height();
     WSScreen::the().set_y_offset(new_y_offset);
     m_buffers_are_flipped = !m_buffers_are_flipped;
@@ -48,10 +73,6 @@ WSWindowManager::WSWindowManager()
 {
     s_the = this;
 
-#ifndef DEBUG_COUNTERS
-    (void)m_compose_count;
-    (void)m_flush_count;
-#endif
     auto size = m_screen_rect.size();
     m_front_bitmap = GraphicsBitmap::create_wrapper(GraphicsBitmap::Format::RGB32, size, m_screen.scanline(0));
     m_back_bitmap = GraphicsBitmap::create_wrapper(GraphicsBitmap::Format::RGB32, size, m_screen.scanline(size.height()));
@@ -62,6 +83,9 @@ WSWindowManager::WSWindowManager()
     m_front_painter->set_font(font());
     m_back_painter->set_font(font());
 
+    // Neither buffer has been painted yet.
+    m_previous_frame_damage = Region(m_screen_rect);
+
     m_background_color = Color(50, 50, 50);
     m_active_window_border_color = Color(110, 34, 9);
     m_active_window_border_color2 = Color(244, 202, 158);
@@ -103,6 +127,10 @@ WSWindowManager::WSWindowManager()
         m_system_menu->add_item(make<WSMenuItem>(102, "1024x768"));
         m_system_menu->add_item(make<WSMenuItem>(103, "1920x1080"));
         m_system_menu->add_item(make<WSMenuItem>(WSMenuItem::Separator));
+        m_system_menu->add_item(make<WSMenuItem>(300, "30 fps"));
+        m_system_menu->add_item(make<WSMenuItem>(301, "60 fps"));
+        m_system_menu->add_item(make<WSMenuItem>(302, "120 fps"));
+        m_system_menu->add_item(make<WSMenuItem>(WSMenuItem::Separator));
         m_system_menu->add_item(make<WSMenuItem>(200, "About..."));
         m_system_menu->on_item_activation = [this] (WSMenuItem& item) {
             if (item.identifier() == 0) {
@@ -124,6 +152,9 @@ WSWindowManager::WSWindowManager()
             case 101: set_resolution(800, 600); break;
             case 102: set_resolution(1024, 768); break;
             case 103: set_resolution(1920, 1080); break;
+            case 300: set_frame_rate(30); break;
+            case 301: set_frame_rate(60); break;
+            case 302: set_frame_rate(120); break;
             }
             if (item.identifier() == 200) {
                 if (fork() == 0) {
@@ -141,6 +172,13 @@ WSWindowManager::WSWindowManager()
     // NOTE: This ensures that the system menu has the correct dimensions.
     set_current_menubar(nullptr);
 
+    int rc = pipe(m_wallpaper_load_fds);
+    ASSERT(rc == 0);
+    rc = pipe(m_wallpaper_finished_fds);
+    ASSERT(rc == 0);
+    WSMessageLoop::the().add_read_notifier(m_wallpaper_finished_fds[0], [this] { finish_wallpaper_load(); });
+    create_thread(wallpaper_decoder_thread, this);
+
     create_thread([] (void* context) -> int {
         auto& wm = *(WSWindowManager*)context;
         for (;;) {
@@ -205,32 +243,38 @@ void get_cpu_usage(unsigned& busy, unsigned& idle)
     busy = 0;
     idle = 0;
 
-    FILE* fp = fopen("/proc/all", "r");
-    if (!fp) {
-        perror("failed to open /proc/all");
+    static int fd = -1;
+    if (fd < 0)
+        fd = open("/proc/all_binary", O_RDONLY);
+    if (fd < 0 || lseek(fd, 0, SEEK_SET) < 0) {
+        perror("failed to open /proc/all_binary");
         ASSERT_NOT_REACHED();
     }
+    static Vector<byte>* buffer = new Vector<byte>;
+    buffer->clear_with_capacity();
     for (;;) {
-        char buf[BUFSIZ];
-        char* ptr = fgets(buf, sizeof(buf), fp);
-        if (!ptr)
-            break;
-        auto parts = String(buf, Chomp).split(',');
-        if (parts.size() < 17)
+        int offset = buffer->size();
+        buffer->resize(max(offset * 2, 4096));
+        ssize_t nread = read(fd, buffer->data() + offset, buffer->size() - offset);
+        if (nread < 0) {
+            perror("read");
+            ASSERT_NOT_REACHED();
+        }
+        buffer->resize(offset + nread);
+        if (nread == 0)
             break;
-        bool ok;
-        pid_t pid = parts[0].to_uint(ok);
-        ASSERT(ok);
-        unsigned nsched = parts[1].to_uint(ok);
-        ASSERT(ok);
-
-        if (pid == 0)
-            idle += nsched;
+    }
+    ASSERT(buffer->size() >= (int)sizeof(ProcessStatisticsHeader));
+    auto& header = *(const ProcessStatisticsHeader*)buffer->data();
+    ASSERT(header.version == PROCESS_STATISTICS_VERSION);
+    ASSERT(header.record_size == sizeof(ProcessStatistics));
+    auto* records = (const ProcessStatistics*)(buffer->data() + sizeof(ProcessStatisticsHeader));
+    for (dword i = 0; i < header.process_count; ++i) {
+        if (records[i].pid == 0)
+            idle += records[i].times_scheduled;
         else
-            busy += nsched;
+            busy += records[i].times_scheduled;
     }
-    int rc = fclose(fp);
-    ASSERT(rc == 0);
 }
 
 void WSWindowManager::tick_clock()
@@ -238,16 +282,53 @@ void WSWindowManager::tick_clock()
     invalidate(menubar_rect());
 }
 
-bool WSWindowManager::set_wallpaper(const String& path)
+int WSWindowManager::wallpaper_decoder_thread(void* context)
 {
-    auto bitmap = load_png(path);
-    if (!bitmap)
-        return false;
+    auto& wm = *(WSWindowManager*)context;
+    for (;;) {
+        WallpaperLoad* load;
+        ssize_t nread = read(wm.m_wallpaper_load_fds[0], &load, sizeof(load));
+        if (nread != sizeof(load)) {
+            perror("read");
+            ASSERT_NOT_REACHED();
+        }
+        // Decode with load_png() rather than through the image cache: the cache belongs to the main thread,
+        // and it would keep the previous wallpaper alive until the next unrelated decode.
+        load->bitmap = load_png(load->path);
+        ssize_t nwritten = write(wm.m_wallpaper_finished_fds[1], &load, sizeof(load));
+        if (nwritten != sizeof(load)) {
+            perror("write");
+            ASSERT_NOT_REACHED();
+        }
+    }
+}
 
-    m_wallpaper_path = path;
-    m_wallpaper = move(bitmap);
-    invalidate();
-    return true;
+void WSWindowManager::set_wallpaper(const String& path, Function<void(bool)>&& callback)
+{
+    auto load = make<WallpaperLoad>();
+    // A private copy, since the decoder thread retains and releases it while we're not looking.
+    load->path = String(path.characters(), path.length());
+    load->callback = move(callback);
+    auto* load_ptr = load.ptr();
+    m_wallpaper_loads.append(move(load));
+    ssize_t nwritten = write(m_wallpaper_load_fds[1], &load_ptr, sizeof(load_ptr));
+    ASSERT(nwritten == sizeof(load_ptr));
+}
+
+void WSWindowManager::finish_wallpaper_load()
+{
+    WallpaperLoad* load_ptr;
+    ssize_t nread = read(m_wallpaper_finished_fds[0], &load_ptr, sizeof(load_ptr));
+    ASSERT(nread == sizeof(load_ptr));
+    ASSERT(!m_wallpaper_loads.is_empty() && m_wallpaper_loads.first().ptr() == load_ptr);
+    auto load = m_wallpaper_loads.take_first();
+    bool success = load->bitmap;
+    if (success) {
+        m_wallpaper_path = load->path;
+        m_wallpaper = move(load->bitmap);
+        invalidate();
+    }
+    load->callback(success);
 }
 
 void WSWindowManager::set_resolution(int width, int height)
@@ -263,6 +344,10 @@ void WSWindowManager::set_resolution(int width, int height)
     m_front_painter = make<Painter>(*m_front_bitmap);
     m_back_painter = make<Painter>(*m_back_bitmap);
     m_buffers_are_flipped = false;
+    m_previous_frame_damage = Region(m_screen_rect);
+    m_front_cursor_save_under.rect = { };
+    m_back_cursor_save_under.rect = { };
+    invalidate_occlusions();
     invalidate();
     compose();
 
@@ -310,6 +395,7 @@ void WSWindowManager::add_window(WSWindow& window)
 {
     m_windows.set(&window);
     m_windows_in_order.append(&window);
+    invalidate_occlusions();
     if (!active_window() || active_window()->client() == window.client())
         set_active_window(&window);
     if (m_switcher.is_visible() && window.type() != WSWindowType::WindowSwitcher)
@@ -335,6 +421,7 @@ void WSWindowManager::move_to_front_and_make_active(WSWindow& window)
         invalidate(window);
     m_windows_in_order.remove(&window);
     m_windows_in_order.append(&window);
+    invalidate_occlusions();
 
     set_active_window(&window);
 }
@@ -347,6 +434,7 @@ void WSWindowManager::remove_window(WSWindow& window)
     invalidate(window);
     m_windows.remove(&window);
     m_windows_in_order.remove(&window);
+    invalidate_occlusions();
     if (!active_window() && !m_windows.is_empty())
         set_active_window(*m_windows.begin());
     if (m_switcher.is_visible() && window.type() != WSWindowType::WindowSwitcher)
@@ -387,6 +475,7 @@ void WSWindowManager::notify_rect_changed(WSWindow& window, const Rect& old_rect
 {
     UNUSED_PARAM(old_rect);
     UNUSED_PARAM(new_rect);
+    invalidate_occlusions();
 #ifdef RESIZE_DEBUG
     dbgprintf("[WM] WSWindow %p rect changed (%d,%d %dx%d) -> (%d,%d %dx%d)\n", &window, old_rect.x(), old_rect.y(), old_rect.width(), old_rect.height(), new_rect.x(), new_rect.y(), new_rect.width(), new_rect.height());
 #endif
@@ -397,6 +486,7 @@ void WSWindowManager::notify_rect_changed(WSWindow& window, const Rect& old_rect
 
 void WSWindowManager::notify_minimization_state_changed(WSWindow& window)
 {
+    invalidate_occlusions();
     tell_wm_listeners_window_state_changed(window);
 }
 
@@ -685,94 +775,80 @@ void WSWindowManager::process_mouse_event(const WSMouseEvent& event, WSWindow*&
     });
 }
 
+static bool window_is_opaque(const WSWindow& window)
+{
+    // FIXME: Just because the window has an alpha channel doesn't mean it's not opaque.
+    //        Maybe there's some way we could know this?
+    return window.opacity() == 1.0f && !window.has_alpha_channel();
+}
+
+void WSWindowManager::recompute_occlusions()
+{
+    // Walk the windows front to back, carving each opaque one out of everything behind it.
+    Region covered;
+    for_each_visible_window_from_front_to_back([&] (WSWindow& window) {
+        auto frame_rect = Rect::intersection(window.frame().rect(), m_screen_rect);
+        Region visible_region(frame_rect);
+        visible_region.subtract(covered);
+        if (window_is_opaque(window))
+            covered.add(frame_rect);
+        window.set_visible_region(move(visible_region));
+        return IterationDecision::Continue;
+    });
+
+    m_visible_background_region = Region(m_screen_rect);
+    m_visible_background_region.subtract(covered);
+
+    m_occlusions_dirty = false;
+}
+
 void WSWindowManager::compose()
 {
-    auto dirty_rects = move(m_dirty_rects);
-    dirty_rects.add(Rect::intersection(m_last_cursor_rect, m_screen_rect));
-    dirty_rects.add(Rect::intersection(current_cursor_rect(), m_screen_rect));
-#ifdef DEBUG_COUNTERS
-    dbgprintf("[WM] compose #%u (%u rects)\n", ++m_compose_count, dirty_rects.rects().size());
-#endif
+    struct timeval compose_start_time;
+    gettimeofday(&compose_start_time, nullptr);
+    m_last_compose_time = compose_start_time;
+
+    // Clients get their paint requests at frame boundaries, so they repaint in step with us
+    // instead of once for every little invalidation.
+    WSClientConnection::for_each_client([] (WSClientConnection& client) {
+        client.flush_pending_paint_requests();
+    });
 
-    auto any_opaque_window_contains_rect = [this] (const Rect& r) {
-        for (auto* window = m_windows_in_order.head(); window; window = window->next()) {
-            if (!window->is_visible())
-                continue;
-            if (window->is_minimized())
-                continue;
-            if (window->opacity() < 1.0f)
-                continue;
-            if (window->has_alpha_channel()) {
-                // FIXME: Just because the window has an alpha channel doesn't mean it's not opaque.
-                //        Maybe there's some way we could know this?
-                continue;
-            }
-            if (window->frame().rect().contains(r))
-                return true;
-        }
-        return false;
-    };
+    auto damage = move(m_dirty_region);
+    damage.simplify(32, 20);
 
-    auto any_opaque_window_above_this_one_contains_rect = [this] (const WSWindow& a_window, const Rect& rect) -> bool {
-        bool found = false;
-        bool checking = false;
-        for_each_visible_window_from_back_to_front([&] (WSWindow& window) {
-            if (&window == &a_window) {
-                checking = true;
-                return IterationDecision::Continue;
-            }
-            if (!checking)
-                return IterationDecision::Continue;
-            if (!window.is_visible())
-                return IterationDecision::Continue;
-            if (window.is_minimized())
-                return IterationDecision::Continue;
-            if (window.opacity() < 1.0f)
-                return IterationDecision::Continue;
-            if (window.has_alpha_channel())
-                return IterationDecision::Continue;
-            if (window.frame().rect().contains(rect)) {
-                found = true;
-                return IterationDecision::Abort;
-            }
-            return IterationDecision::Continue;
-        });
-        return found;
-    };
+    // We never copy between the buffers. The back buffer was last presented two frames ago,
+    // so it's missing both this frame's damage and the damage we painted into the front buffer
+    // last frame. Repaint the union of the two, and presentation is just a flip.
+    auto dirty_region = damage;
+    dirty_region.add(m_previous_frame_damage);
+    dirty_region.simplify(32, 20);
 
-    auto any_dirty_rect_intersects_window = [&dirty_rects] (const WSWindow& window) {
-        auto window_frame_rect = window.frame().rect();
-        for (auto& dirty_rect : dirty_rects.rects()) {
-            if (dirty_rect.intersects(window_frame_rect))
-                return true;
-        }
-        return false;
-    };
+    if (m_occlusions_dirty)
+        recompute_occlusions();
 
-    for (auto& dirty_rect : dirty_rects.rects()) {
-        if (any_opaque_window_contains_rect(dirty_rect))
-            continue;
+    // Each dirty pixel is painted by whatever is visible there, so unless there are translucent
+    // windows in the way, everything is painted exactly once.
+    auto background_region = m_visible_background_region;
+    background_region.intersect(dirty_region);
+    for (auto& rect : background_region.rects()) {
         if (!m_wallpaper)
-            m_back_painter->fill_rect(dirty_rect, m_background_color);
+            m_back_painter->fill_rect(rect, m_background_color);
         else
-            m_back_painter->blit(dirty_rect.location(), *m_wallpaper, dirty_rect);
+            m_back_painter->blit(rect.location(), *m_wallpaper, rect);
     }
 
     for_each_visible_window_from_back_to_front([&] (WSWindow& window) {
         RetainPtr<GraphicsBitmap> backing_store = window.backing_store();
-        if (!any_dirty_rect_intersects_window(window))
-            return IterationDecision::Continue;
-        PainterStateSaver saver(*m_back_painter);
-        m_back_painter->add_clip_rect(window.frame().rect());
-        for (auto& dirty_rect : dirty_rects.rects()) {
-            if (any_opaque_window_above_this_one_contains_rect(window, dirty_rect))
-                continue;
+        auto paint_region = window.visible_region();
+        paint_region.intersect(dirty_region);
+        for (auto& rect : paint_region.rects()) {
             PainterStateSaver saver(*m_back_painter);
-            m_back_painter->add_clip_rect(dirty_rect);
+            m_back_painter->add_clip_rect(rect);
             window.frame().paint(*m_back_painter);
             if (!backing_store)
                 continue;
-            Rect dirty_rect_in_window_coordinates = Rect::intersection(dirty_rect, window.rect());
+            Rect dirty_rect_in_window_coordinates = Rect::intersection(rect, window.rect());
             if (dirty_rect_in_window_coordinates.is_empty())
                 continue;
             dirty_rect_in_window_coordinates.move_by(-window.position());
@@ -787,16 +863,45 @@ void WSWindowManager::compose()
     });
 
     draw_menubar();
-    draw_cursor();
+    draw_cursor(*m_back_painter, *m_back_bitmap, m_back_cursor_save_under);
 
+    // Flash this frame's damage on screen before flipping. The front buffer becomes the back
+    // buffer, and the next frame repaints exactly this damage there, so the yellow never sticks.
     if (m_flash_flush) {
-        for (auto& rect : dirty_rects.rects())
+        for (auto& rect : damage.rects())
             m_front_painter->fill_rect(rect, Color::Yellow);
     }
 
     flip_buffers();
-    for (auto& r : dirty_rects.rects())
-        flush(r);
+
+    // The buffer we just flipped away from still has the cursor in it. Clean it up now,
+    // while nobody's looking, so it's back to being pure scene for the next frame.
+    erase_cursor(*m_back_bitmap, m_back_cursor_save_under);
+
+    auto& statistics = m_frame_statistics;
+    ++statistics.frame_count;
+    statistics.compose_time_us = microseconds_since(compose_start_time);
+    statistics.rect_count = dirty_region.rects().size();
+    statistics.pixel_count = dirty_region.area();
+    statistics.max_compose_time_us = max(statistics.max_compose_time_us, statistics.compose_time_us);
+    statistics.total_compose_time_us += statistics.compose_time_us;
+    statistics.total_pixel_count += statistics.pixel_count;
+#ifdef DEBUG_COUNTERS
+    dbgprintf("[WM] frame #%u: %d us, %d damage rects, %d repainted rects, %d repainted pixels (avg %u us, max %d us)\n",
+        statistics.frame_count,
+        statistics.compose_time_us,
+        damage.rects().size(),
+        statistics.rect_count,
+        statistics.pixel_count,
+        (unsigned)(statistics.total_compose_time_us / statistics.frame_count),
+        statistics.max_compose_time_us);
+#endif
+
+    m_previous_frame_damage = move(damage);
+
+    WSClientConnection::for_each_client([&] (WSClientConnection& client) {
+        client.post_frame_callbacks(statistics.frame_count);
+    });
 }
 
 Rect WSWindowManager::current_cursor_rect() const
@@ -806,7 +911,26 @@ Rect WSWindowManager::current_cursor_rect() const
 
 void WSWindowManager::invalidate_cursor()
 {
-    invalidate(current_cursor_rect());
+    // Don't move the cursor right away, since the mouse events that came with this
+    // may change which cursor we should be showing.
+    if (m_pending_cursor_update_event)
+        return;
+    WSMessageLoop::the().post_message(*this, make<WSMessage>(WSMessage::WM_DeferredCursorUpdate));
+    m_pending_cursor_update_event = true;
+}
+
+void WSWindowManager::update_cursor_overlay()
+{
+    erase_cursor(*m_front_bitmap, m_front_cursor_save_under);
+    draw_cursor(*m_front_painter, *m_front_bitmap, m_front_cursor_save_under);
+}
+
+void WSWindowManager::erase_cursor(GraphicsBitmap& buffer, CursorSaveUnder& save_under)
+{
+    if (save_under.rect.is_empty())
+        return;
+    copy_pixels(buffer, save_under.rect.location(), *save_under.bitmap, { { }, save_under.rect.size() });
+    save_under.rect = { };
 }
 
 Rect WSWindowManager::menubar_rect() const
@@ -885,15 +1009,23 @@ void WSWindowManager::draw_window_switcher()
         m_switcher.draw();
 }
 
-void WSWindowManager::draw_cursor()
+void WSWindowManager::draw_cursor(Painter& painter, GraphicsBitmap& buffer, CursorSaveUnder& save_under)
 {
+    ASSERT(save_under.rect.is_empty());
     Rect cursor_rect = current_cursor_rect();
+    auto rect = Rect::intersection(cursor_rect, m_screen_rect);
+    if (rect.is_empty())
+        return;
+    if (!save_under.bitmap || save_under.bitmap->width() < rect.width() || save_under.bitmap->height() < rect.height())
+        save_under.bitmap = GraphicsBitmap::create(GraphicsBitmap::Format::RGB32, rect.size());
+    copy_pixels(*save_under.bitmap, { }, buffer, rect);
+    save_under.rect = rect;
+
     Color inner_color = Color::White;
     Color outer_color = Color::Black;
     if (m_screen.mouse_button_state() & (unsigned)MouseButton::Left)
         swap(inner_color, outer_color);
-    m_back_painter->blit(cursor_rect.location(), active_cursor().bitmap(), active_cursor().rect());
-    m_last_cursor_rect = cursor_rect;
+    painter.blit(cursor_rect.location(), active_cursor().bitmap(), active_cursor().rect());
 }
 
 void WSWindowManager::on_message(const WSMessage& message)
@@ -920,6 +1052,12 @@ void WSWindowManager::on_message(const WSMessage& message)
         return;
     }
 
+    if (message.type() == WSMessage::WM_DeferredCursorUpdate) {
+        m_pending_cursor_update_event = false;
+        update_cursor_overlay();
+        return;
+    }
+
     if (message.type() == WSMessage::WM_DeferredCompose) {
         m_pending_compose_event = false;
         compose();
@@ -934,6 +1072,7 @@ void WSWindowManager::set_highlight_window(WSWindow* window)
     if (auto* previous_highlight_window = m_highlight_window.ptr())
         invalidate(*previous_highlight_window);
     m_highlight_window = window ? window->make_weak_ptr() : nullptr;
+    invalidate_occlusions();
     if (m_highlight_window)
         invalidate(*m_highlight_window);
 }
@@ -986,13 +1125,13 @@ void WSWindowManager::set_hovered_window(WSWindow* window)
 
 void WSWindowManager::invalidate()
 {
-    m_dirty_rects.clear_with_capacity();
+    m_dirty_region.clear_with_capacity();
     invalidate(m_screen_rect);
 }
 
 void WSWindowManager::recompose_immediately()
 {
-    m_dirty_rects.clear_with_capacity();
+    m_dirty_region.clear_with_capacity();
     invalidate(m_screen_rect, false);
 }
 
@@ -1002,12 +1141,32 @@ void WSWindowManager::invalidate(const Rect& a_rect, bool should_schedule_compos
     if (rect.is_empty())
         return;
 
-    m_dirty_rects.add(rect);
+    m_dirty_region.add(rect);
+
+    if (should_schedule_compose_event)
+        schedule_compose();
+}
 
-    if (should_schedule_compose_event && !m_pending_compose_event) {
-        WSMessageLoop::the().post_message(*this, make<WSMessage>(WSMessage::WM_DeferredCompose));
-        m_pending_compose_event = true;
+void WSWindowManager::schedule_compose()
+{
+    if (m_pending_compose_event || m_frame_timer_id != -1)
+        return;
+    int ms_until_next_frame = m_frame_interval_ms - microseconds_since(m_last_compose_time) / 1000;
+    if (ms_until_next_frame > 0) {
+        m_frame_timer_id = WSMessageLoop::the().start_timer(ms_until_next_frame, [this] {
+            m_frame_timer_id = -1;
+            schedule_compose();
+        }, false);
+        return;
     }
+    WSMessageLoop::the().post_message(*this, make<WSMessage>(WSMessage::WM_DeferredCompose));
+    m_pending_compose_event = true;
+}
+
+void WSWindowManager::set_frame_rate(int frames_per_second)
+{
+    ASSERT(frames_per_second > 0);
+    m_frame_interval_ms = max(1, 1000 / frames_per_second);
 }
 
 void WSWindowManager::invalidate(const WSWindow& window)
@@ -1029,25 +1188,6 @@ void WSWindowManager::invalidate(const WSWindow& window, const Rect& rect)
     invalidate(inner_rect);
 }
 
-void WSWindowManager::flush(const Rect& a_rect)
-{
-    auto rect = Rect::intersection(a_rect, m_screen_rect);
-
-#ifdef DEBUG_COUNTERS
-    dbgprintf("[WM] flush #%u (%d,%d %dx%d)\n", ++m_flush_count, rect.x(), rect.y(), rect.width(), rect.height());
-#endif
-
-    const RGBA32* front_ptr = m_front_bitmap->scanline(rect.y()) + rect.x();
-    RGBA32* back_ptr = m_back_bitmap->scanline(rect.y()) + rect.x();
-    size_t pitch = m_back_bitmap->pitch();
-
-    for (int y = 0; y < rect.height(); ++y) {
-        fast_dword_copy(back_ptr, front_ptr, rect.width());
-        front_ptr = (const RGBA32*)((const byte*)front_ptr + pitch);
-        back_ptr = (RGBA32*)((byte*)back_ptr + pitch);
-    }
-}
-
 void WSWindowManager::close_menu(WSMenu& menu)
 {
     if (current_menu() == &menu)
@@ -3,7 +3,7 @@
 #include <SharedGraphics/Rect.h>
 #include <SharedGraphics/Color.h>
 #include <SharedGraphics/Painter.h>
-#include <SharedGraphics/DisjointRectSet.h>
+#include <SharedGraphics/Region.h>
 #include <AK/HashTable.h>
 #include <AK/InlineLinkedList.h>
 #include <AK/WeakPtr.h>
@@ -54,8 +54,9 @@ public:
 
     void move_to_front_and_make_active(WSWindow&);
 
+    // The cursor isn't part of the composed image. It's an overlay in the front buffer that
+    // remembers the pixels it covers, so moving it doesn't require a compose.
     void invalidate_cursor();
-    void draw_cursor();
     void draw_menubar();
     void draw_window_switcher();
 
@@ -69,8 +70,29 @@ public:
     void invalidate(const WSWindow&, const Rect&);
     void invalidate(const Rect&, bool should_schedule_compose_event = true);
     void invalidate();
+
+    // Composes at most once per frame interval. Damage that comes in faster than that waits for the next frame.
+    void schedule_compose();
+    void set_frame_rate(int frames_per_second);
+
+    struct FrameStatistics {
+        unsigned frame_count { 0 };
+
+        // The most recent frame.
+        int compose_time_us { 0 };
+        int rect_count { 0 };
+        int pixel_count { 0 };
+
+        // All frames so far.
+        int max_compose_time_us { 0 };
+        qword total_compose_time_us { 0 };
+        qword total_pixel_count { 0 };
+    };
+    const FrameStatistics& frame_statistics() const { return m_frame_statistics; }
+
+    // Call this whenever windows move, resize, restack or change opacity.
+    void invalidate_occlusions() { m_occlusions_dirty = true; }
     void recompose_immediately();
-    void flush(const Rect&);
 
     const Font& font() const;
     const Font& window_title_font() const;
@@ -84,7 +106,8 @@ public:
 
     void set_resolution(int width, int height);
 
-    bool set_wallpaper(const String& path);
+    // The wallpaper is decoded on a separate thread. 'callback' runs on the WindowServer thread once it's in place (or failed to load).
+    void set_wallpaper(const String& path, Function<void(bool)>&& callback);
     String wallpaper_path() const { return m_wallpaper_path; }
 
     const WSCursor& active_cursor() const;
@@ -124,8 +147,17 @@ private:
     void close_current_menu();
     virtual void on_message(const WSMessage&) override;
     void compose();
+    void recompute_occlusions();
     void paint_window_frame(const WSWindow&);
     void flip_buffers();
+
+    struct CursorSaveUnder {
+        RetainPtr<GraphicsBitmap> bitmap;
+        Rect rect;
+    };
+    void draw_cursor(Painter&, GraphicsBitmap&, CursorSaveUnder&);
+    void erase_cursor(GraphicsBitmap&, CursorSaveUnder&);
+    void update_cursor_overlay();
     void tick_clock();
     void tell_wm_listeners_window_state_changed(WSWindow&);
     void tell_wm_listener_about_window(WSWindow& listener, WSWindow&);
@@ -164,17 +196,30 @@ private:
     Point m_resize_origin;
     ResizeDirection m_resize_direction { ResizeDirection::None };
 
-    Rect m_last_cursor_rect;
-
-    unsigned m_compose_count { 0 };
-    unsigned m_flush_count { 0 };
 
     RetainPtr<GraphicsBitmap> m_front_bitmap;
     RetainPtr<GraphicsBitmap> m_back_bitmap;
 
-    DisjointRectSet m_dirty_rects;
+    Region m_dirty_region;
+
+    // What compose() painted into the current front buffer, which the back buffer is still missing.
+    Region m_previous_frame_damage;
+
+    // The parts of the screen where the wallpaper shows through.
+    Region m_visible_background_region;
+    bool m_occlusions_dirty { true };
 
     bool m_pending_compose_event { false };
+    bool m_pending_cursor_update_event { false };
+
+    // What's under the cursor in each buffer. The back buffer's is only in use during compose().
+    CursorSaveUnder m_front_cursor_save_under;
+    CursorSaveUnder m_back_cursor_save_under;
+
+    int m_frame_interval_ms { 1000 / 60 };
+    int m_frame_timer_id { -1 };
+    struct timeval m_last_compose_time { 0, 0 };
+    FrameStatistics m_frame_statistics;
 
     RetainPtr<WSCursor> m_arrow_cursor;
     RetainPtr<WSCursor> m_resize_horizontally_cursor;
@@ -191,6 +236,20 @@ private:
     String m_wallpaper_path;
     RetainPtr<GraphicsBitmap> m_wallpaper;
 
+    struct WallpaperLoad {
+        String path;
+        Function<void(bool)> callback;
+        // Written by the decoder thread before it hands the load back through m_wallpaper_finished_fds.
+        RetainPtr<GraphicsBitmap> bitmap;
+    };
+    void finish_wallpaper_load();
+    static int wallpaper_decoder_thread(void*);
+    // In the order they were requested, which is also the order the decoder thread finishes them in.
+    Vector<OwnPtr<WallpaperLoad>> m_wallpaper_loads;
+    // Loads go to the decoder thread through the first pipe, and come back through the second once decoded.
+    int m_wallpaper_load_fds[2] { -1, -1 };
+    int m_wallpaper_finished_fds[2] { -1, -1 };
+
     bool m_flash_flush { false };
     bool m_buffers_are_flipped { false };
 
@@ -64,6 +64,16 @@ public:
         if (!source.alpha())
             return *this;
 
+        if (alpha() == 255) {
+            // Blending onto an opaque color is the common case, and doesn't need any divisions.
+            dword a = source.alpha();
+            auto mix = [a] (dword dst, dword src) -> byte {
+                dword sum = src * a + dst * (255 - a) + 128;
+                return (sum + (sum >> 8)) >> 8;
+            };
+            return Color(mix(red(), source.red()), mix(green(), source.green()), mix(blue(), source.blue()));
+        }
+
         int d = 255 * (alpha() + source.alpha()) - alpha() * source.alpha();
         byte r = (red() * alpha() * (255 - source.alpha()) + 255 * source.alpha() * source.red()) / d;
         byte g = (green() * alpha() * (255 - source.alpha()) + 255 * source.alpha() * source.green()) / d;
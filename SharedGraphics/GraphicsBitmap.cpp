@@ -1,7 +1,9 @@
 #include <SharedGraphics/GraphicsBitmap.h>
 #include <SharedGraphics/PNGLoader.h>
+#include <AK/HashMap.h>
 #include <AK/MappedFile.h>
 #include <sys/mman.h>
+#include <sys/stat.h>
 #include <unistd.h>
 #include <fcntl.h>
 #include <errno.h>
@@ -28,9 +30,57 @@ Retained<GraphicsBitmap> GraphicsBitmap::create_wrapper(Format format, const Siz
     return adopt(*new GraphicsBitmap(format, size, data));
 }
 
+struct CachedImage {
+    time_t mtime { 0 };
+    off_t size { 0 };
+    RetainPtr<GraphicsBitmap> bitmap;
+};
+
+// Decoded images, keyed by path. An entry is only reused if the file's mtime and size still match,
+// and entries nobody else holds on to are swept out whenever a new image is decoded.
+// FIXME: This is per-process. Sharing decoded images between processes needs a service that owns the
+//        shared buffers, since a shared buffer can only be handed to one peer at a time.
+static HashMap<String, CachedImage>& image_cache()
+{
+    static HashMap<String, CachedImage>* s_cache;
+    if (!s_cache)
+        s_cache = new HashMap<String, CachedImage>;
+    return *s_cache;
+}
+
+static void sweep_image_cache()
+{
+    auto& cache = image_cache();
+    Vector<String> unused_paths;
+    for (auto& it : cache) {
+        if (it.value.bitmap->retain_count() == 1)
+            unused_paths.append(it.key);
+    }
+    for (auto& path : unused_paths)
+        cache.remove(path);
+}
+
 RetainPtr<GraphicsBitmap> GraphicsBitmap::load_from_file(const String& path)
 {
-    return load_png(path);
+    struct stat st;
+    if (stat(path.characters(), &st) < 0)
+        return nullptr;
+
+    auto& cache = image_cache();
+    auto it = cache.find(path);
+    if (it != cache.end()) {
+        auto& cached = (*it).value;
+        if (cached.mtime == st.st_mtime && cached.size == st.st_size)
+            return cached.bitmap.copy_ref();
+        cache.remove(it);
+    }
+
+    auto bitmap = load_png(path);
+    if (!bitmap)
+        return nullptr;
+    sweep_image_cache();
+    cache.set(path, { st.st_mtime, st.st_size, bitmap.copy_ref() });
+    return bitmap;
 }
 
 RetainPtr<GraphicsBitmap> GraphicsBitmap::load_from_file(Format format, const String& path, const Size& size)
@@ -15,6 +15,9 @@ public:
 
     static Retained<GraphicsBitmap> create(Format, const Size&);
     static Retained<GraphicsBitmap> create_wrapper(Format, const Size&, RGBA32*);
+    // Decoded images are cached per process, so loading the same file again hands out the same
+    // bitmap until the file changes. Don't paint into bitmaps you got from here, and don't call this
+    // from secondary threads (use load_png() there).
     static RetainPtr<GraphicsBitmap> load_from_file(const String& path);
     static RetainPtr<GraphicsBitmap> load_from_file(Format, const String& path, const Size&);
     static Retained<GraphicsBitmap> create_with_shared_buffer(Format, Retained<SharedBuffer>&&, const Size&);
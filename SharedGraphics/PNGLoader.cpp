@@ -9,7 +9,10 @@
 #include <string.h>
 #include <SharedGraphics/puff.c>
 #include <serenity.h>
+#include <cpuid.h>
+#include <emmintrin.h>
 
+//#define PNG_DEBUG
 //#define PNG_STOPWATCH_DEBUG
 
 struct PNG_IHDR {
@@ -24,11 +27,6 @@ struct PNG_IHDR {
 
 static_assert(sizeof(PNG_IHDR) == 13);
 
-struct Scanline {
-    byte filter { 0 };
-    ByteBuffer data;
-};
-
 struct PNGLoadingContext {
     int width { -1 };
     int height { -1 };
@@ -40,7 +38,6 @@ struct PNGLoadingContext {
     byte bytes_per_pixel { 0 };
     bool has_seen_zlib_header { false };
     bool has_alpha() const { return color_type & 4; }
-    Vector<Scanline> scanlines;
     RetainPtr<GraphicsBitmap> bitmap;
     byte* decompression_buffer { nullptr };
     int decompression_buffer_size { 0 };
@@ -133,71 +130,132 @@ union [[gnu::packed]] Pixel {
 };
 static_assert(sizeof(Pixel) == 4);
 
+// Adds four packed bytes to four others without letting carries cross byte boundaries.
+[[gnu::always_inline]] static inline dword add_packed_bytes(dword x, dword y)
+{
+    return ((x & 0x7f7f7f7f) + (y & 0x7f7f7f7f)) ^ ((x ^ y) & 0x80808080);
+}
+
+// Averages four packed bytes with four others, rounding down like the Avg filter does.
+[[gnu::always_inline]] static inline dword average_packed_bytes(dword x, dword y)
+{
+    return (x & y) + (((x ^ y) >> 1) & 0x7f7f7f7f);
+}
+
+static bool cpu_has_sse2()
+{
+    static int s_has_sse2 = -1;
+    if (s_has_sse2 == -1) {
+        unsigned eax, ebx, ecx, edx;
+        s_has_sse2 = __get_cpuid(1, &eax, &ebx, &ecx, &edx) && (edx & bit_SSE2);
+    }
+    return s_has_sse2;
+}
+
+// The Paeth filter on all four channels of a pixel at once, in 16-bit lanes. Each pixel still depends on the one
+// before it, so this goes one pixel at a time, but without the per-channel branches of paeth_predictor().
+[[gnu::target("sse2")]] static void unfilter_paeth_sse2(RGBA32* pixels, const RGBA32* pixels_above, int width, dword predictor_mask)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i low_bytes = _mm_set1_epi16(0xff);
+    __m128i a = zero;
+    __m128i c = zero;
+    for (int i = 0; i < width; ++i) {
+        __m128i b = _mm_unpacklo_epi8(_mm_cvtsi32_si128(pixels_above[i] & predictor_mask), zero);
+        // With p = a + b - c: |p - a| = |b - c|, |p - b| = |a - c| and |p - c| = |(b - c) + (a - c)|.
+        __m128i b_minus_c = _mm_sub_epi16(b, c);
+        __m128i a_minus_c = _mm_sub_epi16(a, c);
+        __m128i sum = _mm_add_epi16(b_minus_c, a_minus_c);
+        __m128i pa = _mm_max_epi16(b_minus_c, _mm_sub_epi16(zero, b_minus_c));
+        __m128i pb = _mm_max_epi16(a_minus_c, _mm_sub_epi16(zero, a_minus_c));
+        __m128i pc = _mm_max_epi16(sum, _mm_sub_epi16(zero, sum));
+        __m128i smallest = _mm_min_epi16(pa, _mm_min_epi16(pb, pc));
+        // Ties go to a, then b, like paeth_predictor().
+        __m128i use_a = _mm_cmpeq_epi16(pa, smallest);
+        __m128i use_b = _mm_andnot_si128(use_a, _mm_cmpeq_epi16(pb, smallest));
+        __m128i use_c = _mm_andnot_si128(_mm_or_si128(use_a, use_b), _mm_cmpeq_epi16(zero, zero));
+        __m128i predictor = _mm_or_si128(_mm_or_si128(_mm_and_si128(use_a, a), _mm_and_si128(use_b, b)), _mm_and_si128(use_c, c));
+        __m128i x = _mm_unpacklo_epi8(_mm_cvtsi32_si128(pixels[i]), zero);
+        x = _mm_and_si128(_mm_add_epi16(x, predictor), low_bytes);
+        RGBA32 result = _mm_cvtsi128_si32(_mm_packus_epi16(x, zero));
+        pixels[i] = result;
+        a = _mm_unpacklo_epi8(_mm_cvtsi32_si128(result & predictor_mask), zero);
+        c = b;
+    }
+}
+
+[[gnu::always_inline]] static inline dword swap_red_and_blue(dword rgba)
+{
+    return (rgba & 0xff00ff00) | ((rgba >> 16) & 0xff) | ((rgba & 0xff) << 16);
+}
+
+// Unpacks one raw scanline into the bitmap, already in our BGRA channel order.
+// The PNG filters work per channel, so they don't care about the order.
+static void unpack_scanline(PNGLoadingContext& context, int y, const byte* data)
+{
+    auto* pixels = context.bitmap->scanline(y);
+    switch (context.color_type) {
+    case 2: {
+        struct [[gnu::packed]] Triplet { byte r; byte g; byte b; };
+        auto* triplets = (const Triplet*)data;
+        for (int i = 0; i < context.width; ++i)
+            pixels[i] = 0xff000000 | (triplets[i].r << 16) | (triplets[i].g << 8) | triplets[i].b;
+        break;
+    }
+    case 6: {
+        auto* quads = (const dword*)data;
+        for (int i = 0; i < context.width; ++i)
+            pixels[i] = swap_red_and_blue(quads[i]);
+        break;
+    }
+    default:
+        ASSERT_NOT_REACHED();
+        break;
+    }
+}
+
 template<bool has_alpha, byte filter_type>
 [[gnu::always_inline]] static inline void unfilter_impl(GraphicsBitmap& bitmap, int y, const void* dummy_scanline_data)
 {
+    // Opaque images get 0xff alpha from unpack_scanline(); it must not take part in prediction.
+    constexpr dword predictor_mask = has_alpha ? 0xffffffff : 0x00ffffff;
     auto* dummy_scanline = (const Pixel*)dummy_scanline_data;
-    if constexpr (filter_type == 0) {
-        auto* pixels = (Pixel*)bitmap.scanline(y);
-        for (int i = 0; i < bitmap.width(); ++i) {
-            auto& x = pixels[i];
-            swap(x.r, x.b);
-        }
-    }
 
     if constexpr (filter_type == 1) {
-        auto* pixels = (Pixel*)bitmap.scanline(y);
-        swap(pixels[0].r, pixels[0].b);
-        for (int i = 1; i < bitmap.width(); ++i) {
-            auto& x = pixels[i];
-            swap(x.r, x.b);
-            auto& a = (const Pixel&)pixels[i - 1];
-            x.v[0] += a.v[0];
-            x.v[1] += a.v[1];
-            x.v[2] += a.v[2];
-            if constexpr (has_alpha)
-                x.v[3] += a.v[3];
-        }
+        auto* pixels = bitmap.scanline(y);
+        for (int i = 1; i < bitmap.width(); ++i)
+            pixels[i] = add_packed_bytes(pixels[i], pixels[i - 1] & predictor_mask);
         return;
     }
     if constexpr (filter_type == 2) {
-        auto* pixels = (Pixel*)bitmap.scanline(y);
-        auto* pixels_y_minus_1 = y == 0 ? dummy_scanline : (Pixel*)bitmap.scanline(y - 1);
-        for (int i = 0; i < bitmap.width(); ++i) {
-            auto& x = pixels[i];
-            swap(x.r, x.b);
-            const Pixel& b = pixels_y_minus_1[i];
-            x.v[0] += b.v[0];
-            x.v[1] += b.v[1];
-            x.v[2] += b.v[2];
-            if constexpr (has_alpha)
-                x.v[3] += b.v[3];
-        }
+        if (y == 0)
+            return;
+        auto* pixels = bitmap.scanline(y);
+        auto* pixels_y_minus_1 = bitmap.scanline(y - 1);
+        for (int i = 0; i < bitmap.width(); ++i)
+            pixels[i] = add_packed_bytes(pixels[i], pixels_y_minus_1[i] & predictor_mask);
         return;
     }
     if constexpr (filter_type == 3) {
-        auto* pixels = (Pixel*)bitmap.scanline(y);
-        auto* pixels_y_minus_1 = y == 0 ? dummy_scanline : (Pixel*)bitmap.scanline(y - 1);
+        auto* pixels = bitmap.scanline(y);
+        auto* pixels_y_minus_1 = y == 0 ? (const RGBA32*)dummy_scanline : bitmap.scanline(y - 1);
+        dword a = 0;
         for (int i = 0; i < bitmap.width(); ++i) {
-            auto& x = pixels[i];
-            swap(x.r, x.b);
-            Pixel a;
-            if (i != 0) a = pixels[i - 1];
-            const Pixel& b = pixels_y_minus_1[i];
-            x.v[0] = x.v[0] + ((a.v[0] + b.v[0]) / 2);
-            x.v[1] = x.v[1] + ((a.v[1] + b.v[1]) / 2);
-            x.v[2] = x.v[2] + ((a.v[2] + b.v[2]) / 2);
-            if constexpr (has_alpha)
-                x.v[3] = x.v[3] + ((a.v[3] + b.v[3]) / 2);
+            pixels[i] = add_packed_bytes(pixels[i], average_packed_bytes(a, pixels_y_minus_1[i] & predictor_mask));
+            a = pixels[i] & predictor_mask;
         }
         return;
     }
     if constexpr (filter_type == 4) {
+        if (cpu_has_sse2()) {
+            auto* pixels_y_minus_1 = y == 0 ? (const RGBA32*)dummy_scanline : bitmap.scanline(y - 1);
+            unfilter_paeth_sse2(bitmap.scanline(y), pixels_y_minus_1, bitmap.width(), predictor_mask);
+            return;
+        }
         auto* pixels = (Pixel*)bitmap.scanline(y);
         auto* pixels_y_minus_1 = y == 0 ? dummy_scanline : (Pixel*)bitmap.scanline(y - 1);
         for (int i = 0; i < bitmap.width(); ++i) {
             auto& x = pixels[i];
-            swap(x.r, x.b);
             Pixel a;
             const Pixel& b = pixels_y_minus_1[i];
             Pixel c;
@@ -214,81 +272,53 @@ template<bool has_alpha, byte filter_type>
     }
 }
 
-[[gnu::noinline]] static void unfilter(PNGLoadingContext& context)
+template<bool has_alpha>
+static bool unfilter_scanline(GraphicsBitmap& bitmap, int y, byte filter, const void* dummy_scanline_data)
 {
-    {
-#ifdef PNG_STOPWATCH_DEBUG
-    Stopwatch sw("load_png_impl: unfilter: unpack");
-#endif
-    // First unpack the scanlines to RGBA:
-    switch (context.color_type) {
+    switch (filter) {
+    case 0:
+        return true;
+    case 1:
+        unfilter_impl<has_alpha, 1>(bitmap, y, dummy_scanline_data);
+        return true;
     case 2:
-        for (int y = 0; y < context.height; ++y) {
-            struct [[gnu::packed]] Triplet { byte r; byte g; byte b; };
-            auto* triplets = (Triplet*)context.scanlines[y].data.pointer();
-            for (int i = 0; i < context.width; ++i) {
-                auto& pixel = (Pixel&)context.bitmap->scanline(y)[i];
-                pixel.r = triplets[i].r;
-                pixel.g = triplets[i].g;
-                pixel.b = triplets[i].b;
-                pixel.a = 0xff;
-            }
-        }
-        break;
-    case 6:
-        for (int y = 0; y < context.height; ++y) {
-            memcpy(context.bitmap->scanline(y), context.scanlines[y].data.pointer(), context.scanlines[y].data.size());
-        }
-        break;
+        unfilter_impl<has_alpha, 2>(bitmap, y, dummy_scanline_data);
+        return true;
+    case 3:
+        unfilter_impl<has_alpha, 3>(bitmap, y, dummy_scanline_data);
+        return true;
+    case 4:
+        unfilter_impl<has_alpha, 4>(bitmap, y, dummy_scanline_data);
+        return true;
     default:
-        ASSERT_NOT_REACHED();
-        break;
-    }
+        return false;
     }
+}
 
-    auto dummy_scanline = ByteBuffer::create_zeroed(context.width * sizeof(RGBA32));
-
+// Walks the inflated data one scanline at a time, unpacking and unfiltering each row
+// while it (and the row above it) are still hot in the cache.
+[[gnu::noinline]] static bool decode_scanlines(PNGLoadingContext& context)
+{
 #ifdef PNG_STOPWATCH_DEBUG
-    Stopwatch sw("load_png_impl: unfilter: process");
+    Stopwatch sw("load_png_impl: decode scanlines");
 #endif
+    auto dummy_scanline = ByteBuffer::create_zeroed(context.width * sizeof(RGBA32));
+    Streamer streamer(context.decompression_buffer, context.decompression_buffer_size);
     for (int y = 0; y < context.height; ++y) {
-        auto filter = context.scanlines[y].filter;
-        if (filter == 0) {
-            if (context.has_alpha())
-                unfilter_impl<true, 0>(*context.bitmap, y, dummy_scanline.pointer());
-            else
-                unfilter_impl<false, 0>(*context.bitmap, y, dummy_scanline.pointer());
-            continue;
-        }
-        if (filter == 1) {
-            if (context.has_alpha())
-                unfilter_impl<true, 1>(*context.bitmap, y, dummy_scanline.pointer());
-            else
-                unfilter_impl<false, 1>(*context.bitmap, y, dummy_scanline.pointer());
-            continue;
-        }
-        if (filter == 2) {
-            if (context.has_alpha())
-                unfilter_impl<true, 2>(*context.bitmap, y, dummy_scanline.pointer());
-            else
-                unfilter_impl<false, 2>(*context.bitmap, y, dummy_scanline.pointer());
-            continue;
-        }
-        if (filter == 3) {
-            if (context.has_alpha())
-                unfilter_impl<true, 3>(*context.bitmap, y, dummy_scanline.pointer());
-            else
-                unfilter_impl<false, 3>(*context.bitmap, y, dummy_scanline.pointer());
-            continue;
-        }
-        if (filter == 4) {
-            if (context.has_alpha())
-                unfilter_impl<true, 4>(*context.bitmap, y, dummy_scanline.pointer());
-            else
-                unfilter_impl<false, 4>(*context.bitmap, y, dummy_scanline.pointer());
-            continue;
-        }
+        byte filter;
+        if (!streamer.read(filter))
+            return false;
+        ByteBuffer scanline_data;
+        if (!streamer.wrap_bytes(scanline_data, context.width * context.bytes_per_pixel))
+            return false;
+        unpack_scanline(context, y, scanline_data.pointer());
+        bool ok = context.has_alpha()
+            ? unfilter_scanline<true>(*context.bitmap, y, filter, dummy_scanline.pointer())
+            : unfilter_scanline<false>(*context.bitmap, y, filter, dummy_scanline.pointer());
+        if (!ok)
+            return false;
     }
+    return true;
 }
 
 static RetainPtr<GraphicsBitmap> load_png_impl(const byte* data, int data_size)
@@ -330,30 +360,14 @@ static RetainPtr<GraphicsBitmap> load_png_impl(const byte* data, int data_size)
 #endif
         unsigned long srclen = context.compressed_data.size() - 6;
         unsigned long destlen = context.decompression_buffer_size;
+        // FIXME: puff is a bit-at-a-time inflater that needs the whole stream up front. A table-driven one that
+        //        hands over rows as they come out would let decode_scanlines() start before inflate finishes.
         int ret = puff(context.decompression_buffer, &destlen, context.compressed_data.data() + 2, &srclen);
         if (ret < 0)
             return nullptr;
         context.compressed_data.clear();
     }
 
-    {
-#ifdef PNG_STOPWATCH_DEBUG
-        Stopwatch sw("load_png_impl: extract scanlines");
-#endif
-        context.scanlines.ensure_capacity(context.height);
-        Streamer streamer(context.decompression_buffer, context.decompression_buffer_size);
-        for (int y = 0; y < context.height; ++y) {
-            byte filter;
-            if (!streamer.read(filter))
-                return nullptr;
-
-            context.scanlines.append({ filter });
-            auto& scanline_buffer = context.scanlines.last().data;
-            if (!streamer.wrap_bytes(scanline_buffer, context.width * context.bytes_per_pixel))
-                return nullptr;
-        }
-    }
-
     {
 #ifdef PNG_STOPWATCH_DEBUG
         Stopwatch sw("load_png_impl: create bitmap");
@@ -361,12 +375,14 @@ static RetainPtr<GraphicsBitmap> load_png_impl(const byte* data, int data_size)
         context.bitmap = GraphicsBitmap::create(context.has_alpha() ? GraphicsBitmap::Format::RGBA32 : GraphicsBitmap::Format::RGB32, { context.width, context.height });
     }
 
-    unfilter(context);
+    bool decoded = decode_scanlines(context);
 
     munmap(context.decompression_buffer, context.decompression_buffer_size);
     context.decompression_buffer = nullptr;
     context.decompression_buffer_size = 0;
 
+    if (!decoded)
+        return nullptr;
     return context.bitmap;
 }
 
@@ -394,9 +410,11 @@ static bool process_IHDR(const ByteBuffer& data, PNGLoadingContext& context)
         ASSERT_NOT_REACHED();
     }
 
+#ifdef PNG_DEBUG
     printf("PNG: %dx%d (%d bpp)\n", context.width, context.height, context.bit_depth);
     printf("     Color type: %b\n", context.color_type);
     printf(" Interlace type: %b\n", context.interlace_method);
+#endif
 
     context.decompression_buffer_size = (context.width * context.height * context.bytes_per_pixel + context.height);
     context.decompression_buffer = (byte*)mmap(nullptr, context.decompression_buffer_size, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_PRIVATE, 0, 0);
@@ -432,7 +450,9 @@ static bool process_chunk(Streamer& streamer, PNGLoadingContext& context)
         printf("Bail at chunk_crc\n");
         return false;
     }
+#ifdef PNG_DEBUG
     printf("Chunk type: '%s', size: %u, crc: %x\n", chunk_type, chunk_size, chunk_crc);
+#endif
 
     if (!strcmp((const char*)chunk_type, "IHDR"))
         return process_IHDR(chunk_data, context);
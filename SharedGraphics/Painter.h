@@ -25,7 +25,8 @@ public:
     void set_pixel(const Point&, Color);
     void draw_line(const Point&, const Point&, Color);
     void draw_focus_rect(const Rect&);
-    void draw_scaled_bitmap(const Rect& dst_rect, const GraphicsBitmap&, const Rect& src_rect);
+    enum class ScalingMode { NearestNeighbor, Bilinear };
+    void draw_scaled_bitmap(const Rect& dst_rect, const GraphicsBitmap&, const Rect& src_rect, ScalingMode = ScalingMode::NearestNeighbor);
     void blit(const Point&, const GraphicsBitmap&, const Rect& src_rect);
     void blit_with_opacity(const Point&, const GraphicsBitmap&, const Rect& src_rect, float opacity);
 
@@ -54,6 +55,9 @@ public:
 
     GraphicsBitmap* target() { return m_target.ptr(); }
 
+    // Lets benchmarks force the scalar row kernels on CPUs that have SIMD ones, to compare the two.
+    static void set_simd_enabled(bool);
+
     void save() { m_state_stack.append(m_state_stack.last()); }
     void restore() { ASSERT(m_state_stack.size() > 1); m_state_stack.take_last(); }
 
@@ -61,6 +65,8 @@ protected:
     void set_pixel_with_draw_op(dword& pixel, const Color&);
     void fill_rect_with_draw_op(const Rect&, Color);
     void blit_with_alpha(const Point&, const GraphicsBitmap&, const Rect& src_rect);
+    void blend_row(RGBA32* dst, const RGBA32* src, int count);
+    void draw_text_run(const Point&, const char* text, int length, const Font&, Color);
 
     struct State {
         const Font* font;
@@ -0,0 +1,258 @@
+#include <SharedGraphics/Region.h>
+#include <AK/StdLibExtras.h>
+
+Region::Region(const Rect& rect)
+{
+    if (!rect.is_empty())
+        m_rects.append(rect);
+}
+
+Rect Region::bounding_rect() const
+{
+    if (m_rects.is_empty())
+        return { };
+    Rect rect = m_rects.first();
+    for (auto& r : m_rects)
+        rect = rect.united(r);
+    return rect;
+}
+
+int Region::area() const
+{
+    int area = 0;
+    for (auto& rect : m_rects)
+        area += rect.width() * rect.height();
+    return area;
+}
+
+bool Region::contains(const Rect& rect) const
+{
+    if (rect.is_empty())
+        return true;
+    for (auto& r : m_rects) {
+        if (r.contains(rect))
+            return true;
+    }
+    Region remainder(rect);
+    remainder.subtract(*this);
+    return remainder.is_empty();
+}
+
+bool Region::intersects(const Rect& rect) const
+{
+    for (auto& r : m_rects) {
+        if (r.top() > rect.bottom())
+            break;
+        if (r.intersects(rect))
+            return true;
+    }
+    return false;
+}
+
+void Region::add(const Rect& rect)
+{
+    if (rect.is_empty())
+        return;
+    if (m_rects.is_empty()) {
+        m_rects.append(rect);
+        return;
+    }
+    add(Region(rect));
+}
+
+void Region::add(const Region& other)
+{
+    if (other.is_empty())
+        return;
+    if (is_empty()) {
+        m_rects = other.m_rects;
+        return;
+    }
+    m_rects = combine(m_rects, other.m_rects, Operation::Union);
+}
+
+void Region::intersect(const Rect& rect)
+{
+    intersect(Region(rect));
+}
+
+void Region::intersect(const Region& other)
+{
+    if (is_empty())
+        return;
+    if (other.is_empty()) {
+        m_rects.clear();
+        return;
+    }
+    m_rects = combine(m_rects, other.m_rects, Operation::Intersection);
+}
+
+void Region::subtract(const Rect& rect)
+{
+    if (!intersects(rect))
+        return;
+    subtract(Region(rect));
+}
+
+void Region::subtract(const Region& other)
+{
+    if (is_empty() || other.is_empty())
+        return;
+    m_rects = combine(m_rects, other.m_rects, Operation::Difference);
+}
+
+void Region::simplify(int max_rect_count, int max_extra_area_percent)
+{
+    if (m_rects.size() <= 1)
+        return;
+    auto bounds = bounding_rect();
+    int area = this->area();
+    int bounds_area = bounds.width() * bounds.height();
+    if (m_rects.size() > max_rect_count || (bounds_area - area) * 100 <= area * max_extra_area_percent) {
+        m_rects.clear_with_capacity();
+        m_rects.append(bounds);
+    }
+}
+
+namespace {
+
+struct Span {
+    int left;
+    int end;
+};
+
+struct Band {
+    const Rect* rects { nullptr };
+    int count { 0 };
+};
+
+}
+
+static const int infinity = 0x7fffffff;
+
+// Finds the band of 'rects' covering 'y', starting the search at 'index'.
+static Band band_at(const Vector<Rect>& rects, int& index, int y)
+{
+    while (index < rects.size() && rects[index].bottom() < y)
+        ++index;
+    if (index == rects.size() || rects[index].top() > y)
+        return { };
+    int count = 1;
+    while (index + count < rects.size() && rects[index + count].top() == rects[index].top())
+        ++count;
+    return { &rects[index], count };
+}
+
+// Band boundaries are stored as [left, right + 1) pairs, so boundary 'i' of a band
+// opens a span when 'i' is even and closes it when 'i' is odd.
+static int boundary(const Band& band, int i)
+{
+    if (i >= band.count * 2)
+        return infinity;
+    auto& rect = band.rects[i / 2];
+    return (i % 2) ? rect.right() + 1 : rect.left();
+}
+
+template<typename Callback>
+static void combine_spans(const Band& a, const Band& b, Vector<Span>& spans, Callback is_inside)
+{
+    spans.clear_with_capacity();
+    int ia = 0;
+    int ib = 0;
+    bool inside = false;
+    int span_left = 0;
+    for (;;) {
+        int next_a = boundary(a, ia);
+        int next_b = boundary(b, ib);
+        int x = min(next_a, next_b);
+        if (x == infinity)
+            break;
+        if (next_a == x)
+            ++ia;
+        if (next_b == x)
+            ++ib;
+        bool now_inside = is_inside(ia % 2, ib % 2);
+        if (now_inside && !inside)
+            span_left = x;
+        else if (!now_inside && inside)
+            spans.append({ span_left, x });
+        inside = now_inside;
+    }
+}
+
+static void append_boundaries(const Vector<Rect>& rects, Vector<int>& ys)
+{
+    for (int i = 0; i < rects.size(); ++i) {
+        if (i && rects[i].top() == rects[i - 1].top())
+            continue;
+        ys.append(rects[i].top());
+        ys.append(rects[i].bottom() + 1);
+    }
+}
+
+Vector<Rect> Region::combine(const Vector<Rect>& a, const Vector<Rect>& b, Operation operation)
+{
+    // Merge the band boundaries of both regions. Each list is already sorted.
+    Vector<int> a_ys;
+    Vector<int> b_ys;
+    append_boundaries(a, a_ys);
+    append_boundaries(b, b_ys);
+    Vector<int> ys;
+    ys.ensure_capacity(a_ys.size() + b_ys.size());
+    for (int i = 0, j = 0; i < a_ys.size() || j < b_ys.size();) {
+        int y;
+        if (j == b_ys.size() || (i < a_ys.size() && a_ys[i] < b_ys[j]))
+            y = a_ys[i++];
+        else
+            y = b_ys[j++];
+        if (ys.is_empty() || ys.last() != y)
+            ys.append(y);
+    }
+
+    auto is_inside = [operation] (bool in_a, bool in_b) {
+        switch (operation) {
+        case Operation::Union:
+            return in_a || in_b;
+        case Operation::Intersection:
+            return in_a && in_b;
+        case Operation::Difference:
+            return in_a && !in_b;
+        }
+        ASSERT_NOT_REACHED();
+    };
+
+    Vector<Rect> output;
+    Vector<Span> spans;
+    int a_index = 0;
+    int b_index = 0;
+    int previous_band_start = -1;
+    for (int k = 0; k + 1 < ys.size(); ++k) {
+        int top = ys[k];
+        int height = ys[k + 1] - top;
+        combine_spans(band_at(a, a_index, top), band_at(b, b_index, top), spans, is_inside);
+        if (spans.is_empty())
+            continue;
+
+        // If the band above us is identical and touches this one, just make it taller.
+        if (previous_band_start != -1 && output.last().bottom() + 1 == top && output.size() - previous_band_start == spans.size()) {
+            bool identical = true;
+            for (int i = 0; i < spans.size(); ++i) {
+                auto& rect = output[previous_band_start + i];
+                if (rect.left() != spans[i].left || rect.right() + 1 != spans[i].end) {
+                    identical = false;
+                    break;
+                }
+            }
+            if (identical) {
+                for (int i = previous_band_start; i < output.size(); ++i)
+                    output[i].set_height(output[i].height() + height);
+                continue;
+            }
+        }
+
+        previous_band_start = output.size();
+        for (auto& span : spans)
+            output.append({ span.left, top, span.end - span.left, height });
+    }
+    return output;
+}
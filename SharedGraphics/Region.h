@@ -0,0 +1,44 @@
+#pragma once
+
+#include <AK/Vector.h>
+#include <SharedGraphics/Rect.h>
+
+// A set of pixels, stored as non-overlapping rects in y-bands.
+// The rects are sorted top to bottom, then left to right. All rects in a band have the same
+// top and bottom, and don't touch each other. Vertically adjacent bands with identical rects
+// are merged into one, so every region has exactly one representation.
+class Region {
+public:
+    Region() { }
+    Region(const Rect&);
+
+    bool is_empty() const { return m_rects.is_empty(); }
+    const Vector<Rect>& rects() const { return m_rects; }
+
+    Rect bounding_rect() const;
+    int area() const;
+
+    bool contains(const Rect&) const;
+    bool intersects(const Rect&) const;
+
+    void add(const Rect&);
+    void add(const Region&);
+    void intersect(const Rect&);
+    void intersect(const Region&);
+    void subtract(const Rect&);
+    void subtract(const Region&);
+
+    // Turns the region into its bounding rect, if that's at most 'max_extra_area_percent' bigger,
+    // or if the region has more than 'max_rect_count' rects. A few extra pixels are often cheaper
+    // to repaint than a lot of slivers.
+    void simplify(int max_rect_count, int max_extra_area_percent);
+
+    void clear() { m_rects.clear(); }
+    void clear_with_capacity() { m_rects.clear_with_capacity(); }
+
+private:
+    enum class Operation { Union, Intersection, Difference };
+    static Vector<Rect> combine(const Vector<Rect>& a, const Vector<Rect>& b, Operation);
+
+    Vector<Rect> m_rects;
+};
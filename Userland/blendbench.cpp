@@ -0,0 +1,159 @@
+#include <LibGUI/GElapsedTimer.h>
+#include <SharedGraphics/GraphicsBitmap.h>
+#include <SharedGraphics/Painter.h>
+#include <AK/Function.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// Times Painter's fill, blit and blend paths on window-sized bitmaps, and prints megapixels per second for each.
+// The blends are timed three ways: the per-pixel Color::blend() loops Painter used before its row kernels,
+// the scalar row kernels, and the SIMD row kernels. The last two must produce identical pixels, which is checked.
+// usage: blendbench [iterations]
+
+static const int width = 640;
+static const int height = 480;
+
+static void run(const char* name, int iterations, Function<void()>&& callback)
+{
+    GElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < iterations; ++i)
+        callback();
+    int ms = max(1, timer.elapsed());
+    // Kilopixels per millisecond is megapixels per second.
+    int kilopixels = width * height / 1000 * iterations;
+    printf("%s: %d ms, %d Mpx/s\n", name, ms, kilopixels / ms);
+}
+
+// The loop blit_with_alpha() ran before the row kernels.
+static void old_blit_with_alpha(GraphicsBitmap& target, const GraphicsBitmap& source)
+{
+    for (int y = 0; y < height; ++y) {
+        auto* dst = target.scanline(y);
+        auto* src = source.scanline(y);
+        for (int x = 0; x < width; ++x) {
+            byte alpha = Color::from_rgba(src[x]).alpha();
+            if (alpha == 0xff)
+                dst[x] = src[x];
+            else if (!alpha)
+                continue;
+            else
+                dst[x] = Color::from_rgba(dst[x]).blend(Color::from_rgba(src[x])).value();
+        }
+    }
+}
+
+// The loop blit_with_opacity() ran before the row kernels.
+static void old_blit_with_opacity(GraphicsBitmap& target, const GraphicsBitmap& source, byte alpha)
+{
+    for (int y = 0; y < height; ++y) {
+        auto* dst = target.scanline(y);
+        auto* src = source.scanline(y);
+        for (int x = 0; x < width; ++x) {
+            Color src_color_with_alpha = Color::from_rgb(src[x]);
+            src_color_with_alpha.set_alpha(alpha);
+            Color dst_color = Color::from_rgb(dst[x]);
+            dst[x] = dst_color.blend(src_color_with_alpha).value();
+        }
+    }
+}
+
+// Draws with the scalar and then the SIMD kernels onto the same background, and compares the results.
+// RGB32 targets ignore the alpha byte, so only the color channels are compared.
+static bool kernels_agree(const char* name, const GraphicsBitmap& background, Function<void(Painter&)>&& draw)
+{
+    Retained<GraphicsBitmap> results[2] = {
+        GraphicsBitmap::create(GraphicsBitmap::Format::RGB32, { width, height }),
+        GraphicsBitmap::create(GraphicsBitmap::Format::RGB32, { width, height }),
+    };
+    for (int i = 0; i < 2; ++i) {
+        Painter::set_simd_enabled(i == 1);
+        Painter painter(*results[i]);
+        painter.blit({ 0, 0 }, background, background.rect());
+        draw(painter);
+    }
+    Painter::set_simd_enabled(true);
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            RGBA32 scalar = results[0]->scanline(y)[x] & 0xffffff;
+            RGBA32 simd = results[1]->scanline(y)[x] & 0xffffff;
+            if (scalar != simd) {
+                printf("%s: scalar and SIMD kernels differ at %d,%d: %x vs %x\n", name, x, y, scalar, simd);
+                return false;
+            }
+        }
+    }
+    printf("%s: scalar and SIMD kernels agree\n", name);
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    int iterations = argc > 1 ? atoi(argv[1]) : 100;
+    if (iterations <= 0) {
+        fprintf(stderr, "usage: blendbench [iterations]\n");
+        return 1;
+    }
+
+    auto target = GraphicsBitmap::create(GraphicsBitmap::Format::RGB32, { width, height });
+    auto opaque_source = GraphicsBitmap::create(GraphicsBitmap::Format::RGB32, { width, height });
+    auto alpha_source = GraphicsBitmap::create(GraphicsBitmap::Format::RGBA32, { width, height });
+    auto small_source = GraphicsBitmap::create(GraphicsBitmap::Format::RGBA32, { width / 4, height / 4 });
+
+    // Vary the alpha across the source so the blend kernels can't take their all-opaque or all-clear shortcuts.
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            opaque_source->scanline(y)[x] = 0xff000000 | ((x * 0x010203) ^ (y * 0x030201));
+            alpha_source->scanline(y)[x] = ((x + y) & 0xff) << 24 | ((x * 0x010203) ^ (y * 0x030201));
+        }
+    }
+    for (int y = 0; y < small_source->height(); ++y) {
+        for (int x = 0; x < small_source->width(); ++x)
+            small_source->scanline(y)[x] = alpha_source->scanline(y)[x];
+    }
+
+    bool ok = kernels_agree("blit (alpha)", *opaque_source, [&](Painter& painter) {
+        painter.blit({ 0, 0 }, *alpha_source, alpha_source->rect());
+    });
+    ok &= kernels_agree("blit_with_opacity", *opaque_source, [&](Painter& painter) {
+        painter.blit_with_opacity({ 0, 0 }, *alpha_source, alpha_source->rect(), 0.3f);
+    });
+
+    Painter painter(*target);
+    printf("%dx%d, %d iterations\n", width, height, iterations);
+    run("fill_rect", iterations, [&] {
+        painter.fill_rect(target->rect(), Color::MidGray);
+    });
+    run("blit (opaque)", iterations, [&] {
+        painter.blit({ 0, 0 }, *opaque_source, opaque_source->rect());
+    });
+    run("blit (alpha, old Color::blend loop)", iterations, [&] {
+        old_blit_with_alpha(*target, *alpha_source);
+    });
+    Painter::set_simd_enabled(false);
+    run("blit (alpha, scalar)", iterations, [&] {
+        painter.blit({ 0, 0 }, *alpha_source, alpha_source->rect());
+    });
+    Painter::set_simd_enabled(true);
+    run("blit (alpha, SIMD)", iterations, [&] {
+        painter.blit({ 0, 0 }, *alpha_source, alpha_source->rect());
+    });
+    run("blit_with_opacity (old Color::blend loop)", iterations, [&] {
+        old_blit_with_opacity(*target, *opaque_source, 127);
+    });
+    Painter::set_simd_enabled(false);
+    run("blit_with_opacity (scalar)", iterations, [&] {
+        painter.blit_with_opacity({ 0, 0 }, *opaque_source, opaque_source->rect(), 0.5f);
+    });
+    Painter::set_simd_enabled(true);
+    run("blit_with_opacity (SIMD)", iterations, [&] {
+        painter.blit_with_opacity({ 0, 0 }, *opaque_source, opaque_source->rect(), 0.5f);
+    });
+    run("scaled (nearest neighbor)", iterations, [&] {
+        painter.draw_scaled_bitmap(target->rect(), *small_source, small_source->rect(), Painter::ScalingMode::NearestNeighbor);
+    });
+    run("scaled (bilinear)", iterations, [&] {
+        painter.draw_scaled_bitmap(target->rect(), *small_source, small_source->rect(), Painter::ScalingMode::Bilinear);
+    });
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,52 @@
+#include <LibGUI/GApplication.h>
+#include <LibGUI/GElapsedTimer.h>
+#include <LibGUI/GWindow.h>
+#include <AK/Function.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// Times WindowServer IPC: synchronous round trips, with and without text in the response,
+// and one-way messages that the client batches up before a single synchronous request.
+// usage: ipcbench [iterations]
+
+static void run(const char* name, int iterations, Function<void()>&& callback)
+{
+    GElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < iterations; ++i)
+        callback();
+    int ms = max(1, timer.elapsed());
+    printf("%s: %d ms, %d us per message\n", name, ms, ms * 1000 / iterations);
+}
+
+int main(int argc, char** argv)
+{
+    GApplication app(argc, argv);
+
+    int iterations = argc > 1 ? atoi(argv[1]) : 10000;
+    if (iterations <= 0) {
+        fprintf(stderr, "usage: ipcbench [iterations]\n");
+        return 1;
+    }
+
+    auto* window = new GWindow;
+    window->set_title("ipcbench");
+    window->set_rect(100, 100, 200, 100);
+    window->show();
+
+    printf("%d iterations\n", iterations);
+    run("round trip (GetWindowRect)", iterations, [&] {
+        (void)window->rect();
+    });
+    run("round trip (GetWindowTitle)", iterations, [&] {
+        (void)window->title();
+    });
+    // The last title() waits for the server to have handled every SetWindowTitle before it.
+    int count = 0;
+    run("one-way (SetWindowTitle)", iterations, [&] {
+        window->set_title(String::format("ipcbench %d", ++count));
+        if (count == iterations)
+            (void)window->title();
+    });
+    return 0;
+}
@@ -0,0 +1,43 @@
+#include <LibGUI/GElapsedTimer.h>
+#include <SharedGraphics/GraphicsBitmap.h>
+#include <SharedGraphics/PNGLoader.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// Times PNG decoding, both straight through load_png() and through GraphicsBitmap's decoded image cache.
+// usage: pngbench [path] [iterations]
+
+int main(int argc, char** argv)
+{
+    const char* path = argc > 1 ? argv[1] : "/res/wallpapers/sunset-retro.png";
+    int iterations = argc > 2 ? atoi(argv[2]) : 10;
+    if (iterations <= 0) {
+        fprintf(stderr, "usage: pngbench [path] [iterations]\n");
+        return 1;
+    }
+
+    auto bitmap = load_png(path);
+    if (!bitmap) {
+        fprintf(stderr, "Failed to load %s\n", path);
+        return 1;
+    }
+    printf("%s: %s, %d iterations\n", path, bitmap->size().to_string().characters(), iterations);
+    int kilopixels = bitmap->width() * bitmap->height() / 1000;
+    bitmap = nullptr;
+
+    GElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < iterations; ++i)
+        bitmap = load_png(path);
+    int ms = max(1, timer.elapsed());
+    // Kilopixels per millisecond is megapixels per second.
+    printf("load_png: %d ms per image, %d Mpx/s\n", ms / iterations, kilopixels * iterations / ms);
+    bitmap = nullptr;
+
+    timer.start();
+    for (int i = 0; i < iterations; ++i)
+        bitmap = GraphicsBitmap::load_from_file(path);
+    ms = timer.elapsed();
+    printf("load_from_file (first decodes, the rest hit the cache): %d ms total\n", ms);
+    return 0;
+}
@@ -0,0 +1,171 @@
+#include <LibGUI/GApplication.h>
+#include <LibGUI/GElapsedTimer.h>
+#include <LibGUI/GEvent.h>
+#include <LibGUI/GModel.h>
+#include <LibGUI/GScrollBar.h>
+#include <LibGUI/GTableView.h>
+#include <LibGUI/GWindow.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// Times GTableView repaints over a large synthetic model at a few scroll offsets, and counts the mallocs in each.
+// The cost of a repaint should depend on how many rows are visible, not on how many rows there are.
+// It then repeats the count the way cells used to be painted, with models formatting numbers into
+// Strings and the view turning every cell into a String, to compare before and after.
+// usage: tablebench [rows] [paints]
+
+// Linked with --wrap=malloc (see the Makefile), so every malloc() from outside LibC's own stdlib comes through here.
+static unsigned s_malloc_count;
+
+extern "C" void* __real_malloc(size_t);
+
+extern "C" void* __wrap_malloc(size_t size)
+{
+    ++s_malloc_count;
+    return __real_malloc(size);
+}
+
+class SyntheticModel final : public GModel {
+public:
+    static Retained<SyntheticModel> create(int row_count, bool formats_numbers) { return adopt(*new SyntheticModel(row_count, formats_numbers)); }
+    virtual ~SyntheticModel() override { }
+
+    enum Column {
+        Index = 0,
+        Name,
+        Value,
+        __Count,
+    };
+
+    virtual int row_count(const GModelIndex&) const override { return m_row_count; }
+    virtual int column_count(const GModelIndex&) const override { return Column::__Count; }
+    virtual String column_name(int column) const override
+    {
+        switch (column) {
+        case Column::Index: return "Index";
+        case Column::Name: return "Name";
+        case Column::Value: return "Value";
+        }
+        ASSERT_NOT_REACHED();
+    }
+    virtual ColumnMetadata column_metadata(int column) const override
+    {
+        if (column == Column::Name)
+            return { 120, TextAlignment::CenterLeft };
+        return { 80, TextAlignment::CenterRight };
+    }
+    virtual GVariant data(const GModelIndex& index, Role role) const override
+    {
+        if (role != Role::Display && role != Role::Sort)
+            return { };
+        switch (index.column()) {
+        case Column::Index: return index.row();
+        case Column::Name: return m_names[index.row() % m_names.size()];
+        case Column::Value: {
+            int value = ((unsigned)index.row() * 2654435761u) % 100000;
+            if (m_formats_numbers)
+                return String::format("%d", value);
+            return value;
+        }
+        }
+        ASSERT_NOT_REACHED();
+    }
+    virtual void update() override { did_update(); }
+
+private:
+    SyntheticModel(int row_count, bool formats_numbers)
+        : m_row_count(row_count)
+        , m_formats_numbers(formats_numbers)
+    {
+        m_names.append("alpha");
+        m_names.append("bravo");
+        m_names.append("charlie");
+        m_names.append("a somewhat longer name that gets elided");
+    }
+
+    int m_row_count { 0 };
+    bool m_formats_numbers { false };
+    Vector<String> m_names;
+};
+
+static void benchmark(GTableView& table, int paints)
+{
+    auto& scrollbar = table.vertical_scrollbar();
+    int max_offset = scrollbar.max();
+    int offsets[] = { 0, max_offset / 4, max_offset / 2, max_offset };
+    for (int offset : offsets) {
+        scrollbar.set_value(offset);
+        GPaintEvent event(table.rect());
+        GElapsedTimer timer;
+        timer.start();
+        unsigned mallocs_before = s_malloc_count;
+        for (int i = 0; i < paints; ++i)
+            static_cast<GWidget&>(table).paint_event(event);
+        unsigned mallocs = s_malloc_count - mallocs_before;
+        int ms = timer.elapsed();
+        printf("offset %d: %d ms, %d us per paint, %u mallocs per paint\n", offset, ms, ms * 1000 / paints, mallocs / paints);
+    }
+}
+
+// GTableView used to paint each cell's to_string(). It now paints to_text(), which only allocates for types that aren't text.
+static void count_cell_text_mallocs(GTableView& table)
+{
+    auto& model = *table.model();
+    int rows = min(model.row_count(), (table.height() - table.header_height()) / table.item_height() + 1);
+    int columns = model.column_count();
+    unsigned mallocs_before = s_malloc_count;
+    for (int row = 0; row < rows; ++row) {
+        for (int column = 0; column < columns; ++column)
+            (void)model.data(model.index(row, column)).to_string();
+    }
+    unsigned to_string_mallocs = s_malloc_count - mallocs_before;
+    mallocs_before = s_malloc_count;
+    for (int row = 0; row < rows; ++row) {
+        for (int column = 0; column < columns; ++column) {
+            GVariant::TextBuffer buffer;
+            int length;
+            (void)model.data(model.index(row, column)).to_text(buffer, length);
+        }
+    }
+    unsigned to_text_mallocs = s_malloc_count - mallocs_before;
+    printf("cell text for %d visible rows: to_string() %u mallocs, to_text() %u mallocs\n", rows, to_string_mallocs, to_text_mallocs);
+}
+
+int main(int argc, char** argv)
+{
+    GApplication app(argc, argv);
+
+    int rows = argc > 1 ? atoi(argv[1]) : 100000;
+    int paints = argc > 2 ? atoi(argv[2]) : 100;
+    if (rows <= 0 || paints <= 0) {
+        fprintf(stderr, "usage: tablebench [rows] [paints]\n");
+        return 1;
+    }
+
+    auto* window = new GWindow;
+    window->set_title("tablebench");
+    window->set_rect(100, 100, 400, 300);
+    auto* table = new GTableView(nullptr);
+    table->set_model(SyntheticModel::create(rows, false));
+    window->set_main_widget(table);
+    window->show();
+
+    printf("%d rows, %d paints per offset\n", rows, paints);
+    Function<void()> run_once_painted;
+    run_once_painted = [&] {
+        // The window paints into its backing store, which only exists once it has been painted for real.
+        if (!window->back_bitmap()) {
+            window->request_frame_callback([&] { run_once_painted(); });
+            return;
+        }
+        benchmark(*table, paints);
+        count_cell_text_mallocs(*table);
+        printf("with the model formatting numbers into Strings:\n");
+        table->set_model(SyntheticModel::create(rows, true));
+        benchmark(*table, paints);
+        count_cell_text_mallocs(*table);
+        app.quit(0);
+    };
+    window->request_frame_callback([&] { run_once_painted(); });
+    return app.exec();
+}
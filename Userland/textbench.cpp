@@ -0,0 +1,62 @@
+#include <LibGUI/GElapsedTimer.h>
+#include <SharedGraphics/Font.h>
+#include <SharedGraphics/GraphicsBitmap.h>
+#include <SharedGraphics/Painter.h>
+#include <AK/Function.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Times Painter::draw_text() on table-cell-sized runs, and prints thousands of glyphs per second for each case.
+// usage: textbench [iterations]
+
+static const char* sample_text = "The quick brown fox jumps over the lazy dog 0123456789";
+
+static void run(const char* name, int iterations, int glyphs_per_iteration, Function<void()>&& callback)
+{
+    GElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < iterations; ++i)
+        callback();
+    int ms = max(1, timer.elapsed());
+    // Glyphs per millisecond is thousands of glyphs per second.
+    printf("%s: %d ms, %d kglyphs/s\n", name, ms, glyphs_per_iteration * iterations / ms);
+}
+
+int main(int argc, char** argv)
+{
+    int iterations = argc > 1 ? atoi(argv[1]) : 1000;
+    if (iterations <= 0) {
+        fprintf(stderr, "usage: textbench [iterations]\n");
+        return 1;
+    }
+
+    auto target = GraphicsBitmap::create(GraphicsBitmap::Format::RGB32, { 640, 480 });
+    Painter painter(*target);
+    auto& font = Font::default_font();
+    auto& fixed_width_font = Font::default_fixed_width_font();
+    int length = strlen(sample_text);
+    int rows = target->height() / font.glyph_height();
+
+    printf("%d rows of %d characters, %d iterations\n", rows, length, iterations);
+    run("draw_text (proportional)", iterations, rows * length, [&] {
+        for (int row = 0; row < rows; ++row)
+            painter.draw_text({ 0, row * font.glyph_height(), target->width(), font.glyph_height() }, sample_text, length, font, TextAlignment::CenterLeft, Color::Black);
+    });
+    run("draw_text (fixed width)", iterations, rows * length, [&] {
+        for (int row = 0; row < rows; ++row)
+            painter.draw_text({ 0, row * font.glyph_height(), target->width(), font.glyph_height() }, sample_text, length, fixed_width_font, TextAlignment::CenterLeft, Color::Black);
+    });
+    // Every run is cut off partway by the clip, like text in a narrow table column.
+    painter.add_clip_rect({ 0, 0, target->width() / 3, target->height() });
+    run("draw_text (clipped)", iterations, rows * length, [&] {
+        for (int row = 0; row < rows; ++row)
+            painter.draw_text({ 0, row * font.glyph_height(), target->width(), font.glyph_height() }, sample_text, length, font, TextAlignment::CenterLeft, Color::Black);
+    });
+    painter.clear_clip_rect();
+    run("draw_text (elided)", iterations, rows * length, [&] {
+        for (int row = 0; row < rows; ++row)
+            painter.draw_text({ 0, row * font.glyph_height(), target->width() / 3, font.glyph_height() }, sample_text, length, font, TextAlignment::CenterLeft, Color::Black, TextElision::Right);
+    });
+    return 0;
+}
@@ -7,6 +7,7 @@
 #include <AK/AKString.h>
 #include <AK/Vector.h>
 #include <AK/QuickSort.h>
+#include <Kernel/ProcessStatistics.h>
 
 static HashMap<unsigned, String>* s_usernames;
 
@@ -33,42 +34,46 @@ static Snapshot get_snapshot()
 {
     Snapshot snapshot;
 
-    FILE* fp = fopen("/proc/all", "r");
-    if (!fp) {
-        perror("failed to open /proc/all");
+    static int fd = -1;
+    if (fd < 0)
+        fd = open("/proc/all_binary", O_RDONLY);
+    if (fd < 0 || lseek(fd, 0, SEEK_SET) < 0) {
+        perror("failed to open /proc/all_binary");
         exit(1);
     }
+    static Vector<byte>* buffer = new Vector<byte>;
+    buffer->clear_with_capacity();
     for (;;) {
-        char buf[4096];
-        char* ptr = fgets(buf, sizeof(buf), fp);
-        if (!ptr)
-            break;
-        auto parts = String(buf, Chomp).split(',');
-        if (parts.size() < 17)
+        int offset = buffer->size();
+        buffer->resize(max(offset * 2, 4096));
+        ssize_t nread = read(fd, buffer->data() + offset, buffer->size() - offset);
+        if (nread < 0) {
+            perror("read");
+            exit(1);
+        }
+        buffer->resize(offset + nread);
+        if (nread == 0)
             break;
-        bool ok;
-        pid_t pid = parts[0].to_uint(ok);
-        ASSERT(ok);
-        unsigned nsched = parts[1].to_uint(ok);
-        ASSERT(ok);
-        snapshot.sum_nsched += nsched;
+    }
+    ASSERT(buffer->size() >= (int)sizeof(ProcessStatisticsHeader));
+    auto& header = *(const ProcessStatisticsHeader*)buffer->data();
+    ASSERT(header.version == PROCESS_STATISTICS_VERSION);
+    ASSERT(header.record_size == sizeof(ProcessStatistics));
+    auto* records = (const ProcessStatistics*)(buffer->data() + sizeof(ProcessStatisticsHeader));
+    for (dword i = 0; i < header.process_count; ++i) {
+        auto& record = records[i];
+        snapshot.sum_nsched += record.times_scheduled;
         Process process;
-        process.pid = pid;
-        process.nsched = nsched;
-        unsigned uid = parts[5].to_uint(ok);
-        ASSERT(ok);
-        process.user = s_usernames->get(uid);
-        process.priority = parts[16];
-        process.state = parts[7];
-        process.name = parts[11];
-        process.linear = parts[12].to_uint(ok);
-        ASSERT(ok);
-        process.committed = parts[13].to_uint(ok);
-        ASSERT(ok);
-        snapshot.map.set(pid, move(process));
+        process.pid = record.pid;
+        process.nsched = record.times_scheduled;
+        process.user = s_usernames->get(record.uid);
+        process.priority = record.priority;
+        process.state = record.state;
+        process.name = record.name;
+        process.linear = record.amount_virtual;
+        process.committed = record.amount_resident;
+        snapshot.map.set(record.pid, move(process));
     }
-    int rc = fclose(fp);
-    ASSERT(rc == 0);
     return snapshot;
 }
 